@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/archive-diff.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "batch/archives.hpp"
+#include "format-readers/peg.hpp"
+#include "parallel.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+/* Sort key -> entry, so both sides can be walked in step. */
+using EntryMap = std::map<std::string_view, const VfsEntry *>;
+
+struct Side {
+    MmapVfs vfs;
+    EntryMap archives;
+};
+
+struct Difference {
+    std::string path;
+    char kind;    // '+', '-' or '~'
+    std::string detail;
+};
+
+/* Two entries of the same size whose bytes still need comparing. */
+struct Candidate {
+    const VfsEntry *old_entry;
+    const VfsEntry *new_entry;
+    std::string path;
+    bool equal {false};
+};
+
+struct DiffCounts {
+    std::uint64_t added {0};
+    std::uint64_t removed {0};
+    std::uint64_t changed {0};
+    std::uint64_t unchanged {0};
+};
+
+EntryMap by_name(const std::vector<VfsEntry *> &entries)
+{
+    EntryMap map;
+    for (const VfsEntry *entry : entries) {
+        map.emplace(entry->sort_key, entry);
+    }
+    return map;
+}
+
+/* False if the path has no archives or one of them fails to load, since an
+ * empty side would report everything on the other as added or removed. */
+bool load_side(Side &side, const std::string &path)
+{
+    side.vfs.set_access_pattern(AccessPattern::Sequential);
+
+    const auto num_archives = ace3x::batch::find_archives({path}).size();
+    if (num_archives == 0) {
+        spdlog::error("Archive diff: No VPP archives in '{}'", path);
+        return false;
+    }
+
+    const auto roots = ace3x::batch::load_archives(side.vfs, {path}, "Archive diff");
+    for (const VfsEntry *root : roots) {
+        side.archives.emplace(root->sort_key, root);
+    }
+
+    if (roots.size() != num_archives) {
+        spdlog::error("Archive diff: {} of {} archives in '{}' failed to load", num_archives - roots.size(), num_archives, path);
+        return false;
+    }
+
+    return true;
+}
+
+/* Calls on_old, on_new or on_both for each key of the two maps, in order. */
+template <typename OnOld, typename OnNew, typename OnBoth>
+void merge(const EntryMap &old_map, const EntryMap &new_map, OnOld on_old, OnNew on_new, OnBoth on_both)
+{
+    auto old_it = old_map.begin();
+    auto new_it = new_map.begin();
+
+    while (old_it != old_map.end() || new_it != new_map.end()) {
+        if (new_it == new_map.end() || (old_it != old_map.end() && old_it->first < new_it->first)) {
+            on_old((old_it++)->second);
+        }
+        else if (old_it == old_map.end() || new_it->first < old_it->first) {
+            on_new((new_it++)->second);
+        }
+        else {
+            on_both((old_it++)->second, (new_it++)->second);
+        }
+    }
+}
+
+void diff_frames(const VfsEntry *old_peg, const VfsEntry *new_peg, const std::string &peg_path, std::vector<Difference> &differences)
+{
+    auto frame_bytes = [](const VfsEntry *peg, const VfsEntry *frame) {
+        const auto info = ace3x::peg::get_frame_info(peg->data, frame->index);
+        if (static_cast<std::uint64_t>(info.offset) + frame->size > peg->size) {
+            return std::make_pair(info, static_cast<const unsigned char *>(nullptr));
+        }
+        return std::make_pair(info, peg->data + info.offset);
+    };
+
+    merge(
+        by_name(old_peg->entries),
+        by_name(new_peg->entries),
+        [&](const VfsEntry *frame) {
+            differences.push_back({peg_path + '/' + frame->name, '-', ""});
+        },
+        [&](const VfsEntry *frame) {
+            differences.push_back({peg_path + '/' + frame->name, '+', ""});
+        },
+        [&](const VfsEntry *old_frame, const VfsEntry *new_frame) {
+            const auto [old_info, old_data] = frame_bytes(old_peg, old_frame);
+            const auto [new_info, new_data] = frame_bytes(new_peg, new_frame);
+            const auto path = peg_path + '/' + new_frame->name;
+
+            if (old_info.width != new_info.width || old_info.height != new_info.height || old_info.format != new_info.format) {
+                differences.push_back({path, '~', fmt::format("{}x{} 0x{:x} -> {}x{} 0x{:x}", old_info.width, old_info.height, old_info.format, new_info.width, new_info.height, new_info.format)});
+            }
+            else if (old_frame->size != new_frame->size || !old_data || !new_data || std::memcmp(old_data, new_data, new_frame->size) != 0) {
+                differences.push_back({path, '~', "pixels"});
+            }
+        });
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_archive_diff(const ArchiveDiffOptions &options)
+{
+    Side old_side;
+    Side new_side;
+
+    /* Both, so every unusable path is reported. */
+    const bool old_loaded = load_side(old_side, options.old_path);
+    const bool new_loaded = load_side(new_side, options.new_path);
+
+    if (!old_loaded || !new_loaded) {
+        return kDiffError;
+    }
+
+    std::vector<Difference> differences;
+    std::vector<Candidate> candidates;
+    std::vector<std::pair<const VfsEntry *, const VfsEntry *>> changed_pegs;
+    DiffCounts counts;
+
+    auto diff_archives = [&](const VfsEntry *old_archive, const VfsEntry *new_archive) {
+        merge(
+            by_name(old_archive->entries),
+            by_name(new_archive->entries),
+            [&](const VfsEntry *entry) {
+                differences.push_back({new_archive->name + '/' + entry->name, '-', fmt::format("{} bytes", entry->size)});
+                counts.removed++;
+            },
+            [&](const VfsEntry *entry) {
+                differences.push_back({new_archive->name + '/' + entry->name, '+', fmt::format("{} bytes", entry->size)});
+                counts.added++;
+            },
+            [&](const VfsEntry *old_entry, const VfsEntry *new_entry) {
+                const auto path = new_archive->name + '/' + new_entry->name;
+
+                /* Different sizes are enough, no need to read either. */
+                if (old_entry->size != new_entry->size) {
+                    differences.push_back({path, '~', fmt::format("{} -> {} bytes", old_entry->size, new_entry->size)});
+                    counts.changed++;
+                    if (options.frames && entry_format(new_entry) == ace3x::FormatId::Peg) {
+                        changed_pegs.emplace_back(old_entry, new_entry);
+                    }
+                }
+                else {
+                    candidates.push_back({old_entry, new_entry, path});
+                }
+            });
+    };
+
+    /* Two archives given directly are compared whatever their names, so a
+     * renamed or backed up copy can be diffed against the original. */
+    const bool single_archives = !std::filesystem::is_directory(options.old_path) && !std::filesystem::is_directory(options.new_path);
+
+    if (single_archives && old_side.archives.size() == 1 && new_side.archives.size() == 1) {
+        diff_archives(old_side.archives.begin()->second, new_side.archives.begin()->second);
+    }
+    else {
+        merge(
+            old_side.archives,
+            new_side.archives,
+            [&](const VfsEntry *archive) {
+                differences.push_back({archive->name, '-', fmt::format("{} entries", archive->entries.size())});
+                counts.removed += archive->entries.size();
+            },
+            [&](const VfsEntry *archive) {
+                differences.push_back({archive->name, '+', fmt::format("{} entries", archive->entries.size())});
+                counts.added += archive->entries.size();
+            },
+            diff_archives);
+    }
+
+    /* Compare the mapped bytes directly: each pair is read once and the
+     * comparison stops at the first difference, which hashing could not. */
+    parallel_for(resolve_thread_count(options.thread_count), candidates.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; i++) {
+            auto &candidate = candidates[i];
+            candidate.equal = std::memcmp(candidate.old_entry->data, candidate.new_entry->data, candidate.new_entry->size) == 0;
+        }
+    });
+
+    for (const auto &candidate : candidates) {
+        if (candidate.equal) {
+            counts.unchanged++;
+            continue;
+        }
+
+        differences.push_back({candidate.path, '~', "contents"});
+        counts.changed++;
+        if (options.frames && entry_format(candidate.new_entry) == ace3x::FormatId::Peg) {
+            changed_pegs.emplace_back(candidate.old_entry, candidate.new_entry);
+        }
+    }
+
+    const auto num_entry_differences = differences.size();
+
+    for (const auto &[old_peg, new_peg] : changed_pegs) {
+        old_side.vfs.load_children(old_side.vfs.get_entry(old_peg->absolute_path));
+        new_side.vfs.load_children(new_side.vfs.get_entry(new_peg->absolute_path));
+        diff_frames(old_peg, new_peg, new_peg->root->name + '/' + new_peg->name, differences);
+    }
+
+    std::sort(differences.begin(), differences.end(), [](const Difference &a, const Difference &b) {
+        return a.path < b.path;
+    });
+
+    std::ofstream report_file;
+    if (!options.report_path.empty()) {
+        report_file.open(options.report_path, std::ios::trunc);
+        if (!report_file.good()) {
+            spdlog::error("Archive diff: Failed to open '{}' for writing", options.report_path);
+            return kDiffError;
+        }
+    }
+    std::ostream &out = options.report_path.empty() ? std::cout : report_file;
+
+    for (const auto &difference : differences) {
+        out << difference.kind << ' ' << difference.path;
+        if (!difference.detail.empty()) {
+            out << " (" << difference.detail << ')';
+        }
+        out << '\n';
+    }
+    out.flush();
+
+    spdlog::info("Archive diff: {} archives -> {}; {} entries added, {} removed, {} changed, {} unchanged; {} frame differences",
+                 old_side.archives.size(),
+                 new_side.archives.size(),
+                 counts.added,
+                 counts.removed,
+                 counts.changed,
+                 counts.unchanged,
+                 differences.size() - num_entry_differences);
+
+    return differences.empty() ? kDiffIdentical : kDiffDifferent;
+}
+
+}    // namespace ace3x::batch
@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_ARCHIVE_DIFF_HPP_
+#define ACE3X_BATCH_ARCHIVE_DIFF_HPP_
+
+#include <string>
+
+namespace ace3x::batch {
+
+struct ArchiveDiffOptions {
+    /* A VPP archive, or a directory containing them, for each side. */
+    std::string old_path;
+    std::string new_path;
+    /* Also compare the frames of changed PEGs. */
+    bool frames {false};
+    /* If set, differences are written here instead of to stdout. */
+    std::string report_path;
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+/* Exit codes of run_archive_diff, like diff(1). */
+inline constexpr int kDiffIdentical {0};
+inline constexpr int kDiffDifferent {1};
+inline constexpr int kDiffError {2};
+
+/* Matches archives by file name, or pairs them directly when both paths are
+ * archives, then matches their entries by entry name, and reports added,
+ * removed and changed entries. Entries are only compared byte for byte when
+ * their sizes match, and are read through the memory maps, never copied.
+ * A path without archives, or with one that fails to load, is an error
+ * rather than an empty side. */
+int run_archive_diff(const ArchiveDiffOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_ARCHIVE_DIFF_HPP_
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/archives.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+
+#include "vfs/vfs-entry.hpp"
+#include "vfs/vfs.hpp"
+
+namespace {
+
+bool is_vpp(const std::filesystem::path &path)
+{
+    const auto ext = path.extension().string();
+    return ext == ".vpp" || ext == ".VPP";
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+std::vector<std::string> find_archives(const std::vector<std::string> &paths)
+{
+    std::vector<std::string> archives;
+
+    for (const auto &path : paths) {
+        const auto fs_path = std::filesystem::path(path);
+
+        if (std::filesystem::is_directory(fs_path)) {
+            for (const auto &entry : std::filesystem::directory_iterator(fs_path)) {
+                if (entry.is_regular_file() && is_vpp(entry.path())) {
+                    archives.push_back(std::filesystem::absolute(entry.path()).generic_string());
+                }
+            }
+        }
+        else if (std::filesystem::is_regular_file(fs_path) && is_vpp(fs_path)) {
+            archives.push_back(std::filesystem::absolute(fs_path).generic_string());
+        }
+        else {
+            spdlog::warn("Batch: '{}' is not a VPP archive or directory", path);
+        }
+    }
+
+    std::sort(archives.begin(), archives.end());
+    archives.erase(std::unique(archives.begin(), archives.end()), archives.end());
+
+    return archives;
+}
+
+std::vector<VfsEntry *> load_archives(Vfs &vfs, const std::vector<std::string> &paths, const char *tool_name)
+{
+    std::vector<VfsEntry *> roots;
+
+    for (const auto &path : find_archives(paths)) {
+        try {
+            if (!vfs.add_root_archive(path)) {
+                continue;
+            }
+        }
+        catch (const std::exception &e) {
+            spdlog::error("{}: Failed to load '{}': {}", tool_name, path, e.what());
+            continue;
+        }
+
+        roots.push_back(vfs.get_entry(path));
+    }
+
+    return roots;
+}
+
+}    // namespace ace3x::batch
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_ARCHIVES_HPP_
+#define ACE3X_BATCH_ARCHIVES_HPP_
+
+#include <string>
+#include <vector>
+
+class Vfs;
+struct VfsEntry;
+
+namespace ace3x::batch {
+
+/* Expands each path into the VPP archives it names. Directories are searched
+ * (non-recursively) for *.vpp files. Results are absolute and sorted. */
+std::vector<std::string> find_archives(const std::vector<std::string> &paths);
+
+/* Adds the archives find_archives finds in paths to vfs. Archives that fail
+ * to load are logged as "<tool_name>: Failed to load ..." and skipped.
+ * Returns the root entries, in the order of find_archives. */
+std::vector<VfsEntry *> load_archives(Vfs &vfs, const std::vector<std::string> &paths, const char *tool_name);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_ARCHIVES_HPP_
@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/batch-main.hpp"
+
+#include <spdlog/cfg/env.h>
+#include <spdlog/spdlog.h>
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstring>
+
+#include "batch/archive-diff.hpp"
+#include "batch/content-index.hpp"
+#include "batch/decode-benchmark.hpp"
+#include "batch/geometry-export.hpp"
+#include "batch/level-dump.hpp"
+#include "batch/pack.hpp"
+
+namespace {
+
+/* Options that select a headless mode. Checked before any QApplication
+ * exists so batch runs never need a display. */
+constexpr const char *kBatchCommands[] = {
+    "--decode-bench",
+    "--content-index",
+    "--pack",
+    "--patch",
+    "--diff",
+    "--export-geometry",
+    "--dump-levels",
+};
+
+std::vector<std::string> to_std_strings(const QStringList &list)
+{
+    std::vector<std::string> strings;
+    for (const auto &str : list) {
+        strings.push_back(str.toStdString());
+    }
+    return strings;
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+bool is_batch_command(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        for (const char *command : kBatchCommands) {
+            const auto length = std::strlen(command);
+            if (std::strncmp(argv[i], command, length) == 0 && (argv[i][length] == '\0' || argv[i][length] == '=')) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int batch_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Ace3X");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::applicationName());
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "VPP archives or directories containing them", "[paths...]");
+
+    QCommandLineOption decodeBenchOption("decode-bench", "Decode every PEG frame and report throughput");
+    QCommandLineOption checksumsOption("checksums", "Write per-frame checksums to this file", "filename");
+    QCommandLineOption baselineOption("baseline", "Compare per-frame checksums against this file", "filename");
+    QCommandLineOption contentIndexOption("content-index", "Hash every entry and report duplicate and conflicting contents");
+    QCommandLineOption cacheDirOption("cache-dir", "Keep per-archive hashes here (default: ./temp)", "directory", "./temp");
+    QCommandLineOption reportOption("report", "Write duplicates and conflicts to this file", "filename");
+    QCommandLineOption packOption("pack", "Build a VPP archive from loose files, directories and other archives", "output");
+    QCommandLineOption patchOption("patch", "Replace or add entries in an uncompressed VPP archive without rebuilding it", "archive");
+    QCommandLineOption compressOption("compress", "Compress the packed archive");
+    QCommandLineOption levelOption("level", "zlib compression level, 0-9 (default: 6)", "level", "6");
+    QCommandLineOption diffOption("diff", "Compare two archives or directories of archives: old new");
+    QCommandLineOption framesOption("frames", "With --diff, also compare the frames of changed PEGs");
+    QCommandLineOption exportGeometryOption("export-geometry", "Write the geometry of every P3D to this directory", "directory");
+    QCommandLineOption glbOption("glb", "With --export-geometry, write binary glTF instead of OBJ");
+    QCommandLineOption navpointsOption("navpoints", "With --export-geometry, also write navpoints as points");
+    QCommandLineOption dumpLevelsOption("dump-levels", "Write the navpoints, layers, mesh movers, HTWK records and images of every P3D as JSON lines", "file");
+    QCommandLineOption threadsOption("threads", "Number of worker threads (default: all cores)", "count");
+    parser.addOption(decodeBenchOption);
+    parser.addOption(checksumsOption);
+    parser.addOption(baselineOption);
+    parser.addOption(contentIndexOption);
+    parser.addOption(cacheDirOption);
+    parser.addOption(reportOption);
+    parser.addOption(packOption);
+    parser.addOption(patchOption);
+    parser.addOption(compressOption);
+    parser.addOption(levelOption);
+    parser.addOption(diffOption);
+    parser.addOption(framesOption);
+    parser.addOption(exportGeometryOption);
+    parser.addOption(glbOption);
+    parser.addOption(navpointsOption);
+    parser.addOption(dumpLevelsOption);
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    spdlog::set_pattern("[%^%L%$] [%H:%M:%S] %v");
+    spdlog::cfg::load_env_levels();
+
+    const auto paths = to_std_strings(parser.positionalArguments());
+
+    try {
+        if (parser.isSet(decodeBenchOption)) {
+            DecodeBenchmarkOptions options;
+            options.paths = paths;
+            options.checksums_path = parser.value(checksumsOption).toStdString();
+            options.baseline_path = parser.value(baselineOption).toStdString();
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_decode_benchmark(options);
+        }
+        if (parser.isSet(contentIndexOption)) {
+            ContentIndexOptions options;
+            options.paths = paths;
+            options.cache_dir = parser.value(cacheDirOption).toStdString();
+            options.report_path = parser.value(reportOption).toStdString();
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_content_index(options);
+        }
+        if (parser.isSet(packOption)) {
+            PackOptions options;
+            options.inputs = paths;
+            options.output_path = parser.value(packOption).toStdString();
+            options.compress = parser.isSet(compressOption);
+            options.level = parser.value(levelOption).toInt();
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_pack(options);
+        }
+        if (parser.isSet(patchOption)) {
+            PatchOptions options;
+            options.inputs = paths;
+            options.archive_path = parser.value(patchOption).toStdString();
+            return run_patch(options);
+        }
+        if (parser.isSet(diffOption)) {
+            if (paths.size() != 2) {
+                spdlog::error("--diff takes exactly two paths: old new");
+                return kDiffError;
+            }
+            ArchiveDiffOptions options;
+            options.old_path = paths[0];
+            options.new_path = paths[1];
+            options.frames = parser.isSet(framesOption);
+            options.report_path = parser.value(reportOption).toStdString();
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_archive_diff(options);
+        }
+        if (parser.isSet(exportGeometryOption)) {
+            GeometryExportOptions options;
+            options.paths = paths;
+            options.output_dir = parser.value(exportGeometryOption).toStdString();
+            options.format = parser.isSet(glbOption) ? ace3x::mesh::MeshFormat::Glb : ace3x::mesh::MeshFormat::Obj;
+            options.navpoints = parser.isSet(navpointsOption);
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_geometry_export(options);
+        }
+        if (parser.isSet(dumpLevelsOption)) {
+            LevelDumpOptions options;
+            options.paths = paths;
+            options.output_path = parser.value(dumpLevelsOption).toStdString();
+            options.thread_count = parser.value(threadsOption).toUInt();
+            return run_level_dump(options);
+        }
+    }
+    catch (const std::exception &e) {
+        spdlog::error("{}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    parser.showHelp(EXIT_FAILURE);
+}
+
+}    // namespace ace3x::batch
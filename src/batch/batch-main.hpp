@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_BATCH_MAIN_HPP_
+#define ACE3X_BATCH_BATCH_MAIN_HPP_
+
+namespace ace3x::batch {
+
+/* True if the command line asks for a headless mode rather than the GUI. */
+bool is_batch_command(int argc, char *argv[]);
+
+/* Runs the requested headless mode. Returns the process exit code. */
+int batch_main(int argc, char *argv[]);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_BATCH_MAIN_HPP_
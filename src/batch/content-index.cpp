@@ -0,0 +1,288 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/content-index.hpp"
+
+#include <spdlog/spdlog.h>
+#include <xxhash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "batch/archives.hpp"
+#include "parallel.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+constexpr const char *kCacheMagic {"ace3x-content-index 1"};
+
+struct EntryHash {
+    std::string name;
+    std::uint64_t size {0};
+    std::uint64_t hash {0};
+};
+
+struct ArchiveHashes {
+    std::string path;
+    std::string name;
+    std::uint64_t file_size {0};
+    std::int64_t modified {0};
+    bool cached {false};
+    std::vector<EntryHash> entries;
+};
+
+struct HashJob {
+    EntryHash *entry;
+    const unsigned char *data;
+};
+
+/* Where an entry lives: archive and entry indices. */
+using Location = std::pair<std::size_t, std::size_t>;
+/* Hash and size, so a hash collision would also need equal sizes. */
+using ContentKey = std::pair<std::uint64_t, std::uint64_t>;
+
+std::filesystem::path cache_path(const std::string &cache_dir, const ArchiveHashes &archive)
+{
+    const auto path_hash = XXH3_64bits(archive.path.data(), archive.path.size());
+    return std::filesystem::path(cache_dir) / fmt::format("{}.{:016x}.hashes", archive.name, path_hash);
+}
+
+std::string header_line(const ArchiveHashes &archive)
+{
+    return fmt::format("{} {} {}", kCacheMagic, archive.file_size, archive.modified);
+}
+
+bool read_cache(const std::filesystem::path &path, ArchiveHashes &archive)
+{
+    std::ifstream file(path);
+    if (!file.good()) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != header_line(archive)) {
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        EntryHash entry;
+
+        if (!(stream >> std::hex >> entry.hash >> std::dec >> entry.size)) {
+            spdlog::warn("Content index: Ignoring damaged cache '{}'", path.generic_string());
+            archive.entries.clear();
+            return false;
+        }
+
+        stream.get();
+        std::getline(stream, entry.name);
+        archive.entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
+
+void write_cache(const std::filesystem::path &path, const ArchiveHashes &archive)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.good()) {
+        spdlog::warn("Content index: Failed to write cache '{}'", path.generic_string());
+        return;
+    }
+
+    file << header_line(archive) << '\n';
+    for (const auto &entry : archive.entries) {
+        file << fmt::format("{:016x} {} {}\n", entry.hash, entry.size, entry.name);
+    }
+}
+
+std::string to_lower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return str;
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_content_index(const ContentIndexOptions &options)
+{
+    std::error_code error;
+    std::filesystem::create_directories(options.cache_dir, error);
+    if (error) {
+        spdlog::error("Content index: Failed to create cache directory '{}': {}", options.cache_dir, error.message());
+        return EXIT_FAILURE;
+    }
+
+    MmapVfs vfs;
+    vfs.set_access_pattern(AccessPattern::Sequential);
+    std::vector<ArchiveHashes> archives;
+    std::vector<HashJob> jobs;
+    std::uint64_t bytes_to_hash = 0;
+
+    for (const auto &path : find_archives(options.paths)) {
+        ArchiveHashes archive;
+        archive.path = path;
+        archive.name = std::filesystem::path(path).filename().string();
+        archive.file_size = std::filesystem::file_size(path);
+        archive.modified = std::filesystem::last_write_time(path).time_since_epoch().count();
+        archive.cached = read_cache(cache_path(options.cache_dir, archive), archive);
+        archives.push_back(std::move(archive));
+    }
+
+    /* Only archives missing from the cache are loaded. */
+    std::vector<std::string> uncached_paths;
+    for (const auto &archive : archives) {
+        if (!archive.cached) {
+            uncached_paths.push_back(archive.path);
+        }
+    }
+
+    const auto roots = load_archives(vfs, uncached_paths, "Content index");
+
+    archives.erase(std::remove_if(archives.begin(), archives.end(), [&](const ArchiveHashes &archive) {
+                       return !archive.cached && std::find(roots.begin(), roots.end(), vfs.get_entry(archive.path)) == roots.end();
+                   }),
+                   archives.end());
+
+    /* Only now that `archives` is final, since the jobs point into it. */
+    for (auto &archive : archives) {
+        if (archive.cached) {
+            continue;
+        }
+
+        const auto &entries = vfs.get_entry(archive.path)->entries;
+        for (const VfsEntry *entry : entries) {
+            archive.entries.push_back({entry->name, entry->size, 0});
+        }
+
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            jobs.push_back({&archive.entries[i], entries[i]->data});
+            bytes_to_hash += entries[i]->size;
+        }
+    }
+
+    const unsigned num_threads = resolve_thread_count(options.thread_count);
+    const auto num_cached = std::count_if(archives.begin(), archives.end(), [](const ArchiveHashes &archive) {
+        return archive.cached;
+    });
+
+    spdlog::info("Content index: {} archives, {} from cache, {} entries to hash on {} threads", archives.size(), num_cached, jobs.size(), num_threads);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    parallel_for(num_threads, jobs.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; i++) {
+            jobs[i].entry->hash = XXH3_64bits(jobs[i].data, jobs[i].entry->size);
+        }
+    });
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!jobs.empty()) {
+        const double seconds = std::max(elapsed.count(), 1e-9);
+        spdlog::info("Content index: Hashed {:.1f} MB in {:.3f}s, {:.1f} MB/s", bytes_to_hash / 1e6, seconds, bytes_to_hash / seconds / 1e6);
+    }
+
+    for (const auto &archive : archives) {
+        if (!archive.cached) {
+            write_cache(cache_path(options.cache_dir, archive), archive);
+        }
+    }
+
+    std::map<ContentKey, std::vector<Location>> contents;
+    std::map<std::string, std::map<ContentKey, std::vector<Location>>> names;
+
+    for (std::size_t a = 0; a < archives.size(); a++) {
+        for (std::size_t e = 0; e < archives[a].entries.size(); e++) {
+            const auto &entry = archives[a].entries[e];
+            const ContentKey key {entry.hash, entry.size};
+
+            contents[key].emplace_back(a, e);
+            names[to_lower(entry.name)][key].emplace_back(a, e);
+        }
+    }
+
+    std::vector<std::uint64_t> unique_bytes(archives.size());
+    std::vector<std::uint64_t> total_bytes(archives.size());
+    std::uint64_t num_duplicate_groups = 0;
+    std::uint64_t saved_bytes = 0;
+
+    for (const auto &[key, locations] : contents) {
+        std::set<std::size_t> in_archives;
+        for (const auto &[a, e] : locations) {
+            in_archives.insert(a);
+            total_bytes[a] += key.second;
+        }
+
+        if (in_archives.size() == 1) {
+            unique_bytes[*in_archives.begin()] += key.second;
+        }
+
+        if (locations.size() > 1) {
+            num_duplicate_groups++;
+            saved_bytes += (locations.size() - 1) * key.second;
+        }
+    }
+
+    const auto num_conflicts = std::count_if(names.begin(), names.end(), [](const auto &name) {
+        return name.second.size() > 1;
+    });
+
+    for (std::size_t a = 0; a < archives.size(); a++) {
+        spdlog::info("Content index: '{}': {} entries, {} bytes, {} bytes not found in any other archive", archives[a].name, archives[a].entries.size(), total_bytes[a], unique_bytes[a]);
+    }
+
+    spdlog::info("Content index: {} contents stored more than once, {} bytes saved by storing each once", num_duplicate_groups, saved_bytes);
+    spdlog::info("Content index: {} names with differing contents", num_conflicts);
+
+    if (!options.report_path.empty()) {
+        std::ofstream file(options.report_path, std::ios::trunc);
+
+        if (!file.good()) {
+            spdlog::error("Content index: Failed to open '{}' for writing", options.report_path);
+            return EXIT_FAILURE;
+        }
+
+        /* duplicate <hash> <size> <archive>/<name>... */
+        for (const auto &[key, locations] : contents) {
+            if (locations.size() < 2) {
+                continue;
+            }
+            file << fmt::format("duplicate {:016x} {}", key.first, key.second);
+            for (const auto &[a, e] : locations) {
+                file << fmt::format(" {}/{}", archives[a].name, archives[a].entries[e].name);
+            }
+            file << '\n';
+        }
+
+        /* conflict <name> <archive>:<hash>... */
+        for (const auto &[name, versions] : names) {
+            if (versions.size() < 2) {
+                continue;
+            }
+            file << "conflict " << name;
+            for (const auto &[key, locations] : versions) {
+                for (const auto &[a, e] : locations) {
+                    file << fmt::format(" {}:{:016x}", archives[a].name, key.first);
+                }
+            }
+            file << '\n';
+        }
+
+        spdlog::info("Content index: Wrote report to '{}'", options.report_path);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}    // namespace ace3x::batch
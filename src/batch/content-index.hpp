@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_CONTENT_INDEX_HPP_
+#define ACE3X_BATCH_CONTENT_INDEX_HPP_
+
+#include <string>
+#include <vector>
+
+namespace ace3x::batch {
+
+struct ContentIndexOptions {
+    /* VPP files, or directories containing them. */
+    std::vector<std::string> paths;
+    /* Per-archive hash lists are kept here and reused while the archive's
+     * size and modification time are unchanged. */
+    std::string cache_dir {"./temp"};
+    /* If set, every duplicate group and name conflict is written here. */
+    std::string report_path;
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+/* Hashes the contents of every entry in the given archives and reports
+ * content shared between archives, bytes unique to each archive, and entries
+ * with the same name but different contents.
+ * Returns the process exit code. */
+int run_content_index(const ContentIndexOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_CONTENT_INDEX_HPP_
@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/decode-benchmark.hpp"
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+#include "batch/archives.hpp"
+#include "format-readers/peg-texture-decoder.hpp"
+#include "format-readers/peg.hpp"
+#include "formats/peg.hpp"
+#include "parallel.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+constexpr std::size_t kFramesPerChunk {64};
+
+struct FrameJob {
+    /* The archive's path in frame keys, see archive_keys. */
+    const std::string *archive_key;
+    const VfsEntry *peg;
+    PegFrame frame;
+    std::uint32_t index;
+};
+
+struct FrameResult {
+    std::uint32_t crc {0};
+    bool decoded {false};
+    bool in_bounds {false};
+};
+
+struct FormatCount {
+    std::uint64_t frames {0};
+    std::uint64_t pixels {0};
+    bool known {true};
+};
+
+/* Each archive's path relative to the deepest directory containing all of
+ * them, so same-named archives from different inputs get different keys,
+ * while the archives of a single directory are keyed by file name alone. */
+std::unordered_map<const VfsEntry *, std::string> archive_keys(const std::vector<VfsEntry *> &roots)
+{
+    std::unordered_map<const VfsEntry *, std::string> keys;
+
+    if (roots.empty()) {
+        return keys;
+    }
+
+    auto common = std::filesystem::path(roots.front()->absolute_path).parent_path();
+    for (const VfsEntry *root : roots) {
+        const auto directory = std::filesystem::path(root->absolute_path).parent_path();
+        while (common.has_relative_path() && std::mismatch(common.begin(), common.end(), directory.begin(), directory.end()).first != common.end()) {
+            common = common.parent_path();
+        }
+    }
+
+    for (const VfsEntry *root : roots) {
+        keys.emplace(root, std::filesystem::path(root->absolute_path).lexically_relative(common).generic_string());
+    }
+
+    return keys;
+}
+
+std::string frame_key(const FrameJob &job)
+{
+    return fmt::format("{}/{}/{}", *job.archive_key, job.peg->name, job.index);
+}
+
+/* Reads "<key> <name> <format> <WxH> <crc>" lines into key -> crc. */
+std::unordered_map<std::string, std::string> read_baseline(const std::string &path)
+{
+    std::unordered_map<std::string, std::string> baseline;
+
+    std::ifstream file(path);
+    if (!file.good()) {
+        spdlog::error("Decode benchmark: Failed to open baseline '{}'", path);
+        return baseline;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        const auto first_space = line.find(' ');
+        const auto last_space = line.rfind(' ');
+        if (first_space == std::string::npos) {
+            continue;
+        }
+        baseline[line.substr(0, first_space)] = line.substr(last_space + 1);
+    }
+
+    return baseline;
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_decode_benchmark(const DecodeBenchmarkOptions &options)
+{
+    MmapVfs vfs;
+    vfs.set_access_pattern(AccessPattern::Sequential);
+    std::vector<FrameJob> jobs;
+    std::uint64_t num_pegs = 0;
+    std::uint64_t num_skipped = 0;
+
+    const auto roots = load_archives(vfs, options.paths, "Decode benchmark");
+    const auto keys = archive_keys(roots);
+
+    for (const VfsEntry *root : roots) {
+        for (VfsEntry *peg : root->entries) {
+            if (entry_format(peg) != ace3x::FormatId::Peg || peg->size < sizeof(PegHeader)) {
+                continue;
+            }
+
+            PegHeader header;
+            std::memcpy(&header, peg->data, sizeof(PegHeader));
+
+            if (sizeof(PegHeader) + static_cast<std::uint64_t>(header.textureCount) * sizeof(PegFrame) > peg->size) {
+                spdlog::warn("Decode benchmark: '{}/{}' frame table exceeds PEG size", root->name, peg->name);
+                continue;
+            }
+
+            vfs.load_children(peg);
+
+            num_pegs++;
+            num_skipped += header.textureCount - peg->entries.size();
+
+            for (const VfsEntry *frame_entry : peg->entries) {
+                FrameJob job;
+                job.archive_key = &keys.at(root);
+                job.peg = peg;
+                job.index = frame_entry->index;
+                std::memcpy(&job.frame, peg->data + sizeof(PegHeader) + sizeof(PegFrame) * job.index, sizeof(PegFrame));
+                jobs.push_back(job);
+            }
+        }
+    }
+
+    const unsigned num_threads = resolve_thread_count(options.thread_count);
+
+    spdlog::info("Decode benchmark: {} frames in {} PEGs, {} threads", jobs.size(), num_pegs, num_threads);
+
+    std::vector<FrameResult> results(jobs.size());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    /* Frames are handed out in chunks so each reuses one pixel buffer. */
+    parallel_for(num_threads, jobs.size(), kFramesPerChunk, [&](std::size_t begin, std::size_t end) {
+        ace3x::peg::PixelBuffer pixels;
+
+        for (auto i = begin; i < end; i++) {
+            const auto &job = jobs[i];
+            auto &result = results[i];
+
+            if (job.frame.offset + ace3x::peg::payload_size(job.frame.format, job.frame.width, job.frame.height) > job.peg->size) {
+                continue;
+            }
+            result.in_bounds = true;
+
+            pixels.resize(static_cast<std::size_t>(job.frame.width) * job.frame.height);
+
+            result.decoded = ace3x::peg::decode(pixels.data(), job.peg->data + job.frame.offset, job.frame.width, job.frame.height, job.frame.format);
+            result.crc = crc32(0L, reinterpret_cast<const Bytef *>(pixels.data()), static_cast<uInt>(pixels.size() * sizeof(std::uint32_t)));
+        }
+    });
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::map<std::uint16_t, FormatCount> formats;
+    std::uint64_t total_pixels = 0;
+    std::uint64_t num_out_of_bounds = 0;
+
+    for (auto i = 0u; i < jobs.size(); i++) {
+        if (!results[i].in_bounds) {
+            num_out_of_bounds++;
+            continue;
+        }
+
+        const auto pixels = static_cast<std::uint64_t>(jobs[i].frame.width) * jobs[i].frame.height;
+        auto &count = formats[jobs[i].frame.format];
+        count.frames++;
+        count.pixels += pixels;
+        count.known = results[i].decoded;
+        total_pixels += pixels;
+    }
+
+    const double seconds = std::max(elapsed.count(), 1e-9);
+    spdlog::info("Decode benchmark: {:.3f}s, {:.1f} frames/s, {:.1f} Mpixel/s, {:.1f} MB/s out",
+                 seconds,
+                 jobs.size() / seconds,
+                 total_pixels / seconds / 1e6,
+                 total_pixels * 4 / seconds / 1e6);
+
+    for (const auto &[format, count] : formats) {
+        spdlog::info("Decode benchmark: format 0x{:x}: {} frames, {} pixels{}", format, count.frames, count.pixels, count.known ? "" : " (unknown format, not decoded)");
+    }
+
+    spdlog::info("Decode benchmark: {} frames skipped by peg::read_entries, {} frames outside their PEG", num_skipped, num_out_of_bounds);
+
+    if (!options.checksums_path.empty()) {
+        std::ofstream file(options.checksums_path, std::ios::trunc);
+
+        if (!file.good()) {
+            spdlog::error("Decode benchmark: Failed to open '{}' for writing", options.checksums_path);
+            return EXIT_FAILURE;
+        }
+
+        for (auto i = 0u; i < jobs.size(); i++) {
+            const auto &frame = jobs[i].frame;
+            file << fmt::format("{} {} 0x{:x} {}x{} {:08x}\n", frame_key(jobs[i]), std::string(frame.filename, strnlen(frame.filename, sizeof(frame.filename))), frame.format, frame.width, frame.height, results[i].crc);
+        }
+
+        spdlog::info("Decode benchmark: Wrote checksums to '{}'", options.checksums_path);
+    }
+
+    if (!options.baseline_path.empty()) {
+        const auto baseline = read_baseline(options.baseline_path);
+
+        std::uint64_t num_mismatched = 0;
+        std::uint64_t num_missing = 0;
+
+        for (auto i = 0u; i < jobs.size(); i++) {
+            const auto key = frame_key(jobs[i]);
+            const auto it = baseline.find(key);
+
+            if (it == baseline.end()) {
+                num_missing++;
+            }
+            else if (it->second != fmt::format("{:08x}", results[i].crc)) {
+                spdlog::error("Decode benchmark: Checksum mismatch for '{}': {:08x} != {}", key, results[i].crc, it->second);
+                num_mismatched++;
+            }
+        }
+
+        spdlog::info("Decode benchmark: {} frames differ from baseline, {} not in baseline", num_mismatched, num_missing);
+
+        if (num_mismatched || num_missing) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}    // namespace ace3x::batch
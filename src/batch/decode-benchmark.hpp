@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_DECODE_BENCHMARK_HPP_
+#define ACE3X_BATCH_DECODE_BENCHMARK_HPP_
+
+#include <string>
+#include <vector>
+
+namespace ace3x::batch {
+
+struct DecodeBenchmarkOptions {
+    /* VPP files, or directories containing them. */
+    std::vector<std::string> paths;
+    /* If set, one checksum line per decoded frame is written here. */
+    std::string checksums_path;
+    /* If set, checksums are compared against this previously written file. */
+    std::string baseline_path;
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+/* Decodes every PEG frame in the given archives across all cores and reports
+ * throughput, per-format counts and skipped frames.
+ * Returns the process exit code, non-zero if the baseline does not match. */
+int run_decode_benchmark(const DecodeBenchmarkOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_DECODE_BENCHMARK_HPP_
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/geometry-export.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "batch/archives.hpp"
+#include "format-readers/p3d.hpp"
+#include "format-readers/registry.hpp"
+#include "parallel.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+struct ExportJob {
+    const VfsEntry *p3d;
+    std::string output_path;
+    std::uint64_t num_vertices {0};
+    std::uint64_t num_triangles {0};
+    bool failed {false};
+};
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_geometry_export(const GeometryExportOptions &options)
+{
+    MmapVfs vfs;
+    vfs.set_access_pattern(AccessPattern::Sequential);
+
+    const auto extension = options.format == ace3x::mesh::MeshFormat::Glb ? ".glb" : ".obj";
+
+    std::vector<ExportJob> jobs;
+
+    for (const VfsEntry *root : load_archives(vfs, options.paths, "Geometry export")) {
+        const auto directory = std::filesystem::path(options.output_dir) / std::filesystem::path(root->name).stem();
+
+        for (const VfsEntry *entry : root->entries) {
+            if (entry_format(entry) != ace3x::FormatId::P3d) {
+                continue;
+            }
+
+            std::filesystem::create_directories(directory);
+
+            ExportJob job;
+            job.p3d = entry;
+            job.output_path = (directory / std::filesystem::path(entry->name).stem()).generic_string() + extension;
+            jobs.push_back(std::move(job));
+        }
+    }
+
+    const unsigned num_threads = resolve_thread_count(options.thread_count);
+
+    spdlog::info("Geometry export: {} P3Ds, {} threads", jobs.size(), num_threads);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    parallel_for(num_threads, jobs.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; i++) {
+            auto &job = jobs[i];
+            const auto *p3d = job.p3d;
+
+            try {
+                auto geometry = ace3x::p3d::read_geometry(p3d->data, p3d->size, p3d->name);
+                if (options.navpoints) {
+                    ace3x::p3d::add_navpoints(geometry, p3d->data, p3d->size, p3d->name);
+                }
+
+                ace3x::mesh::write(job.output_path, geometry, options.format);
+
+                job.num_vertices = geometry.positions.size() / 3;
+                job.num_triangles = geometry.indices.size() / 3;
+            }
+            catch (const std::exception &e) {
+                spdlog::error("Geometry export: '{}/{}': {}", p3d->root->name, p3d->name, e.what());
+                job.failed = true;
+            }
+        }
+    });
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::uint64_t num_vertices {0};
+    std::uint64_t num_triangles {0};
+    std::uint64_t num_failed {0};
+    for (const auto &job : jobs) {
+        num_vertices += job.num_vertices;
+        num_triangles += job.num_triangles;
+        num_failed += job.failed;
+    }
+
+    spdlog::info("Geometry export: Wrote {} meshes ({} vertices, {} triangles) to '{}' in {:.3f}s, {} failed",
+                 jobs.size() - num_failed,
+                 num_vertices,
+                 num_triangles,
+                 options.output_dir,
+                 elapsed.count(),
+                 num_failed);
+
+    return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}    // namespace ace3x::batch
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_GEOMETRY_EXPORT_HPP_
+#define ACE3X_BATCH_GEOMETRY_EXPORT_HPP_
+
+#include <string>
+#include <vector>
+
+#include "format-writers/mesh.hpp"
+
+namespace ace3x::batch {
+
+struct GeometryExportOptions {
+    /* VPP files, or directories containing them. */
+    std::vector<std::string> paths;
+    /* Each archive's P3Ds go in a subdirectory named after the archive. */
+    std::string output_dir;
+    ace3x::mesh::MeshFormat format {ace3x::mesh::MeshFormat::Obj};
+    /* Also write each navpoint as a point. */
+    bool navpoints {false};
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+/* Reads the geometry of every P3D in the given archives and writes one mesh
+ * file per P3D, in parallel. Returns the process exit code, non-zero if any
+ * P3D could not be read or written. */
+int run_geometry_export(const GeometryExportOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_GEOMETRY_EXPORT_HPP_
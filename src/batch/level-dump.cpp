@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/level-dump.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <fstream>
+
+#include "batch/archives.hpp"
+#include "format-readers/p3d.hpp"
+#include "format-readers/registry.hpp"
+#include "format-writers/json.hpp"
+#include "parallel.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+struct DumpJob {
+    const VfsEntry *p3d;
+    std::string lines;
+    std::uint64_t num_records {0};
+    bool failed {false};
+};
+
+std::string vec3(const std::array<float, 3> &v)
+{
+    return fmt::format("[{},{},{}]", ace3x::json::number(v[0]), ace3x::json::number(v[1]), ace3x::json::number(v[2]));
+}
+
+/* Appends one record; prefix holds the keys every record of the P3D shares. */
+template <typename... Args>
+void add_record(DumpJob &job, const std::string &prefix, const char *format, const Args &...args)
+{
+    job.lines += prefix;
+    job.lines += fmt::format(format, args...);
+    job.lines += "}\n";
+    job.num_records++;
+}
+
+void dump_level(DumpJob &job)
+{
+    const auto *p3d = job.p3d;
+    const auto level = ace3x::p3d::read_level(p3d->data, p3d->size, p3d->name);
+
+    const auto prefix = fmt::format(R"({{"archive":{},"file":{},"table":)", ace3x::json::quoted(p3d->root->name), ace3x::json::quoted(p3d->name));
+
+    add_record(job,
+               prefix,
+               R"("level","position":{},"navpoints":{},"layers":{},"mesh_movers":{},"htwks":{},"images":{})",
+               vec3(level.position),
+               level.navpoints.size(),
+               level.layers.size(),
+               level.mesh_movers.size(),
+               level.htwks.size(),
+               level.images.size());
+
+    for (std::size_t i = 0; i < level.navpoints.size(); i++) {
+        const auto &navpoint = level.navpoints[i];
+        add_record(job,
+                   prefix,
+                   R"("navpoint","index":{},"name":{},"position":{},"unk_0x0":{},"unk_0x4":{},"unk_0x14":{},"unk_0x24":{})",
+                   i,
+                   ace3x::json::quoted(navpoint.name),
+                   vec3(navpoint.position),
+                   navpoint.unk_0x0,
+                   ace3x::json::number(navpoint.unk_0x4),
+                   ace3x::json::number(navpoint.unk_0x14),
+                   ace3x::json::number(navpoint.unk_0x24));
+    }
+
+    for (std::size_t i = 0; i < level.layers.size(); i++) {
+        const auto &layer = level.layers[i];
+        add_record(job, prefix, R"("layer","index":{},"name":{},"num_objects":{},"ptr_0xC":{})", i, ace3x::json::quoted(layer.name), layer.num_objects, layer.ptr_0xC);
+    }
+
+    for (std::size_t i = 0; i < level.mesh_movers.size(); i++) {
+        const auto &mover = level.mesh_movers[i];
+        add_record(job, prefix, R"("mesh_mover","index":{},"name":{},"position":{},"flags":{},"object":{})", i, ace3x::json::quoted(mover.name), vec3(mover.position), mover.flags, mover.object);
+    }
+
+    for (std::size_t i = 0; i < level.htwks.size(); i++) {
+        const auto &htwk = level.htwks[i];
+        std::string values;
+        for (const auto value : htwk.values) {
+            values += values.empty() ? '[' : ',';
+            values += ace3x::json::number(value);
+        }
+        values += ']';
+        add_record(job, prefix, R"("htwk","index":{},"name":{},"unk_0x0":{},"values":{})", i, ace3x::json::quoted(htwk.name), htwk.unk_0x0, values);
+    }
+
+    for (std::size_t i = 0; i < level.images.size(); i++) {
+        add_record(job, prefix, R"("image","index":{},"name":{})", i, ace3x::json::quoted(level.images[i]));
+    }
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_level_dump(const LevelDumpOptions &options)
+{
+    MmapVfs vfs;
+    vfs.set_access_pattern(AccessPattern::Sequential);
+
+    std::vector<DumpJob> jobs;
+
+    for (const VfsEntry *root : load_archives(vfs, options.paths, "Level dump")) {
+        for (const VfsEntry *entry : root->entries) {
+            if (entry_format(entry) == ace3x::FormatId::P3d) {
+                DumpJob job;
+                job.p3d = entry;
+                jobs.push_back(std::move(job));
+            }
+        }
+    }
+
+    std::ofstream file(options.output_path, std::ios::binary | std::ios::trunc);
+    if (!file.good()) {
+        spdlog::error("Level dump: Failed to open '{}' for writing", options.output_path);
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    parallel_for(resolve_thread_count(options.thread_count), jobs.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; i++) {
+            auto &job = jobs[i];
+            try {
+                dump_level(job);
+            }
+            catch (const std::exception &e) {
+                spdlog::error("Level dump: '{}/{}': {}", job.p3d->root->name, job.p3d->name, e.what());
+                job.lines.clear();
+                job.num_records = 0;
+                job.failed = true;
+            }
+        }
+    });
+
+    std::uint64_t num_records {0};
+    std::uint64_t num_failed {0};
+    for (const auto &job : jobs) {
+        file.write(job.lines.data(), static_cast<std::streamsize>(job.lines.size()));
+        num_records += job.num_records;
+        num_failed += job.failed;
+    }
+    file.close();
+
+    if (!file) {
+        spdlog::error("Level dump: Failed to write '{}'", options.output_path);
+        return EXIT_FAILURE;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    spdlog::info("Level dump: Wrote {} records from {} P3Ds to '{}' in {:.3f}s, {} failed",
+                 num_records,
+                 jobs.size() - num_failed,
+                 options.output_path,
+                 elapsed.count(),
+                 num_failed);
+
+    return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}    // namespace ace3x::batch
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_LEVEL_DUMP_HPP_
+#define ACE3X_BATCH_LEVEL_DUMP_HPP_
+
+#include <string>
+#include <vector>
+
+namespace ace3x::batch {
+
+struct LevelDumpOptions {
+    /* VPP files, or directories containing them. */
+    std::vector<std::string> paths;
+    /* JSON lines are written here. */
+    std::string output_path;
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+/* Reads the level tables of every P3D in the given archives in parallel and
+ * writes one JSON object per line: a "level" record per P3D, followed by a
+ * record per navpoint, layer, mesh mover, HTWK record and image. Every record
+ * has "archive", "file" and "table" keys. Records are written in archive and
+ * entry order, so the output only changes when the archives do.
+ * Returns the process exit code, non-zero if any P3D could not be read. */
+int run_level_dump(const LevelDumpOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_LEVEL_DUMP_HPP_
@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "batch/pack.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <unordered_map>
+
+#include "format-readers/vpp.hpp"
+#include "format-writers/vpp.hpp"
+#include "vfs/mio.hpp"
+#include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+bool is_vpp(const std::filesystem::path &path)
+{
+    const auto ext = path.extension().string();
+    return ext == ".vpp" || ext == ".VPP";
+}
+
+std::string to_lower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return str;
+}
+
+class PackInputs {
+public:
+    explicit PackInputs(std::filesystem::path output_path)
+        : output_path_(std::move(output_path))
+    {
+        vfs_.set_access_pattern(AccessPattern::Sequential);
+    }
+
+    void add(const std::string &path)
+    {
+        const auto fs_path = std::filesystem::path(path);
+
+        if (std::filesystem::is_directory(fs_path)) {
+            std::vector<std::filesystem::path> files;
+            for (const auto &entry : std::filesystem::directory_iterator(fs_path)) {
+                /* An earlier run's output would be truncated while mapped. */
+                if (entry.is_regular_file() && std::filesystem::absolute(entry.path()) != output_path_) {
+                    files.push_back(entry.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            for (const auto &file : files) {
+                add_file(file);
+            }
+        }
+        else if (std::filesystem::is_regular_file(fs_path) && is_vpp(fs_path)) {
+            add_archive(fs_path);
+        }
+        else if (std::filesystem::is_regular_file(fs_path)) {
+            add_file(fs_path);
+        }
+        else {
+            spdlog::warn("Pack: '{}' does not exist", path);
+        }
+    }
+
+    const std::vector<ace3x::vpp::WriterEntry> &entries() const
+    {
+        return entries_;
+    }
+
+    const std::array<std::uint32_t, 4> &unknown() const
+    {
+        return unknown_;
+    }
+
+private:
+    void add_file(const std::filesystem::path &path)
+    {
+        ace3x::vpp::WriterEntry entry;
+        entry.filename = path.filename().string();
+
+        if (std::filesystem::file_size(path) > 0) {
+            std::error_code error;
+            auto &mmap = files_.emplace_back();
+            mmap.map(path.string(), error);
+
+            if (error) {
+                spdlog::error("Pack: Failed to map '{}': {}", path.generic_string(), error.message());
+                return;
+            }
+
+            entry.data = reinterpret_cast<const unsigned char *>(mmap.data());
+            entry.size = mmap.size();
+        }
+
+        add_entry(std::move(entry));
+    }
+
+    void add_archive(const std::filesystem::path &path)
+    {
+        const auto absolute_path = std::filesystem::absolute(path).generic_string();
+
+        if (!vfs_.add_root_archive(absolute_path)) {
+            return;
+        }
+
+        /* The directory is never compressed, so the name hashes can be read
+         * straight from the file. */
+        std::error_code error;
+        auto &mmap = files_.emplace_back();
+        mmap.map(absolute_path, error);
+
+        if (error) {
+            spdlog::error("Pack: Failed to map '{}': {}", absolute_path, error.message());
+            return;
+        }
+
+        const auto info = ace3x::vpp::read_info(reinterpret_cast<const unsigned char *>(mmap.data()), path.filename().string());
+
+        std::vector<VppV2DirectoryEntry> directory(info.header.fileCount);
+        std::memcpy(directory.data(), info.data + ace3x::vpp::kChunkSize, directory.size() * sizeof(VppV2DirectoryEntry));
+
+        if (!has_unknown_) {
+            unknown_ = {info.header.unk0, info.header.unk1, info.header.unk2, info.header.unk3};
+            has_unknown_ = true;
+        }
+
+        /* The reader leaves out empty entries and ones that run past the end
+         * of the file, so walk the directory instead. Empty entries are kept,
+         * the others have no data to copy. */
+        std::vector<const VfsEntry *> by_index(directory.size());
+        for (const VfsEntry *vfs_entry : vfs_.get_entry(absolute_path)->entries) {
+            by_index[vfs_entry->index] = vfs_entry;
+        }
+
+        /* add_root_archive has checked that the filenames fit. */
+        const char *filenames = reinterpret_cast<const char *>(info.data + info.filenames_offset);
+        std::uint64_t name_offset = 0;
+        std::size_t num_dropped = 0;
+
+        for (std::size_t i = 0; i < directory.size(); i++) {
+            const auto name_length = strnlen(filenames + name_offset, info.header.filenamesSize - name_offset);
+
+            ace3x::vpp::WriterEntry entry;
+            entry.filename.assign(filenames + name_offset, name_length);
+            entry.name_hash = directory[i].nameHash;
+
+            name_offset = std::min<std::uint64_t>(name_offset + name_length + 1, info.header.filenamesSize);
+
+            if (const VfsEntry *vfs_entry = by_index[i]) {
+                entry.data = vfs_entry->data;
+                entry.size = vfs_entry->size;
+            }
+            else if (directory[i].uncompressedSize != 0) {
+                num_dropped++;
+                continue;
+            }
+
+            add_entry(std::move(entry));
+        }
+
+        if (num_dropped > 0) {
+            spdlog::warn("Pack: Dropped {} of {} entries of '{}' that run past the end of it", num_dropped, directory.size(), absolute_path);
+        }
+    }
+
+    void add_entry(ace3x::vpp::WriterEntry entry)
+    {
+        const auto key = to_lower(entry.filename);
+
+        if (const auto it = indices_.find(key); it != indices_.end()) {
+            spdlog::info("Pack: '{}' replaces an earlier entry", entry.filename);
+            entries_[it->second] = std::move(entry);
+            return;
+        }
+
+        indices_[key] = entries_.size();
+        entries_.push_back(std::move(entry));
+    }
+
+private:
+    std::filesystem::path output_path_;
+    MmapVfs vfs_;
+    std::deque<mio::mmap_source> files_;
+    std::vector<ace3x::vpp::WriterEntry> entries_;
+    std::unordered_map<std::string, std::size_t> indices_;
+    std::array<std::uint32_t, 4> unknown_ {};
+    bool has_unknown_ {false};
+};
+
+bool output_is_input(const std::filesystem::path &output_path, const std::vector<std::string> &inputs)
+{
+    /* Inputs stay mapped while the archive is written. */
+    for (const auto &path : inputs) {
+        if (std::filesystem::absolute(path) == output_path) {
+            spdlog::error("Pack: Output '{}' is also an input", output_path.generic_string());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}    // namespace
+
+namespace ace3x::batch {
+
+int run_pack(const PackOptions &options)
+{
+    const auto output_path = std::filesystem::absolute(options.output_path);
+
+    if (output_is_input(output_path, options.inputs)) {
+        return EXIT_FAILURE;
+    }
+
+    PackInputs inputs(output_path);
+
+    for (const auto &path : options.inputs) {
+        inputs.add(path);
+    }
+
+    ace3x::vpp::WriteOptions write_options;
+    write_options.compress = options.compress;
+    write_options.level = options.level;
+    write_options.thread_count = options.thread_count;
+    write_options.unknown = inputs.unknown();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    ace3x::vpp::write(options.output_path, inputs.entries(), write_options);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    spdlog::info("Pack: Wrote {} entries to '{}' in {:.3f}s", inputs.entries().size(), options.output_path, elapsed.count());
+
+    return EXIT_SUCCESS;
+}
+
+int run_patch(const PatchOptions &options)
+{
+    const auto archive_path = std::filesystem::absolute(options.archive_path);
+
+    if (output_is_input(archive_path, options.inputs)) {
+        return EXIT_FAILURE;
+    }
+
+    PackInputs inputs(archive_path);
+
+    for (const auto &path : options.inputs) {
+        inputs.add(path);
+    }
+
+    if (inputs.entries().empty()) {
+        spdlog::error("Pack: Nothing to patch into '{}'", options.archive_path);
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    ace3x::vpp::patch(options.archive_path, inputs.entries());
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    spdlog::info("Pack: Patched {} entries into '{}' in {:.3f}s", inputs.entries().size(), options.archive_path, elapsed.count());
+
+    return EXIT_SUCCESS;
+}
+
+}    // namespace ace3x::batch
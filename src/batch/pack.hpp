@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_BATCH_PACK_HPP_
+#define ACE3X_BATCH_PACK_HPP_
+
+#include <string>
+#include <vector>
+
+namespace ace3x::batch {
+
+struct PackOptions {
+    /* Loose files, directories of them (not recursive), or VPP archives whose
+     * entries are copied. Later inputs replace earlier entries of the same name. */
+    std::vector<std::string> inputs;
+    std::string output_path;
+    bool compress {false};
+    int level {6};
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+};
+
+struct PatchOptions {
+    /* Same kinds of inputs as PackOptions::inputs. */
+    std::vector<std::string> inputs;
+    /* Uncompressed archive to update. */
+    std::string archive_path;
+};
+
+/* Builds a VPP archive from the inputs. Returns the process exit code. */
+int run_pack(const PackOptions &options);
+
+/* Replaces or adds the inputs' entries in an existing archive, rewriting as
+ * little of it as possible. Returns the process exit code. */
+int run_patch(const PatchOptions &options);
+
+}    // namespace ace3x::batch
+
+#endif    // ACE3X_BATCH_PACK_HPP_
@@ -1,15 +1,16 @@
 #ifndef ACE3X_FORMAT_READERS_ARCHIVE_ENTRY_HPP_
 #define ACE3X_FORMAT_READERS_ARCHIVE_ENTRY_HPP_
 
+#include <cstdint>
 #include <string>
 
 namespace ace3x {
 
 struct ArchiveEntry {
     std::string filename;
-    int index;
-    int size;
-    int offset;
+    std::uint32_t index;
+    std::uint64_t size;
+    std::uint64_t offset;
 };
 
 }    // namespace ace3x
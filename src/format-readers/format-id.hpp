@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_READERS_FORMAT_ID_HPP_
+#define ACE3X_FORMAT_READERS_FORMAT_ID_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ace3x {
+
+/* Index into the format registry. Count must stay last. */
+enum class FormatId : std::uint8_t {
+    Unknown,
+    Vpp,
+    Peg,
+    Tga,
+    Vbm,
+    Tbl,
+    Arr,
+    Vim,
+    P3d,
+    Vf2,
+    Count,
+};
+
+inline constexpr std::size_t kFormatCount {static_cast<std::size_t>(FormatId::Count)};
+
+}    // namespace ace3x
+
+#endif    // ACE3X_FORMAT_READERS_FORMAT_ID_HPP_
@@ -0,0 +1,316 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-readers/p3d.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+#include "format-readers/table.hpp"
+#include "format-readers/validation-error.hpp"
+#include "formats/p3d.hpp"
+
+namespace ace3x::p3d {
+
+namespace {
+
+constexpr std::uint64_t kVertexRecordSize {16};
+
+std::string read_string(const unsigned char *data, std::uint64_t size, std::uint32_t offset)
+{
+    if (offset >= size) {
+        return {};
+    }
+
+    const auto *str = reinterpret_cast<const char *>(data + offset);
+    return std::string(str, strnlen(str, size - offset));
+}
+
+/* The NUL-terminated strings between the header and the object table. */
+class StringBlock {
+public:
+    StringBlock(const unsigned char *data, std::uint64_t size, const P3DHeader &header)
+        : data_(data)
+        , begin_(sizeof(P3DHeader))
+        , end_(std::min<std::uint64_t>(header.ptr_sub1_0x18, size))
+    {
+    }
+
+    std::string at(std::uint32_t offset) const
+    {
+        if (offset < begin_ || offset >= end_) {
+            return {};
+        }
+
+        const auto *str = reinterpret_cast<const char *>(data_ + offset);
+        return std::string(str, strnlen(str, end_ - offset));
+    }
+
+    template <typename F>
+    void for_each(F &&f) const
+    {
+        for (auto offset = begin_; offset < end_;) {
+            const auto str = at(static_cast<std::uint32_t>(offset));
+            if (!str.empty()) {
+                f(str);
+            }
+            offset += str.size() + 1;
+        }
+    }
+
+private:
+    const unsigned char *data_;
+    std::uint64_t begin_;
+    std::uint64_t end_;
+};
+
+bool ends_with_tga(const std::string &str)
+{
+    if (str.size() < 4) {
+        return false;
+    }
+
+    auto ext = str.substr(str.size() - 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return ext == ".tga";
+}
+
+bool is_navpoint_name(const std::string &str)
+{
+    return str.rfind("$player", 0) == 0 || str.rfind("$npc", 0) == 0 || str.rfind("$hostile", 0) == 0;
+}
+
+/* Every offset the header and object table refer to, sorted, so the end of a
+ * block is the next offset after its start. */
+std::vector<std::uint64_t> known_offsets(const P3DHeader &header, const Table<P3DObjInfo> &objects, std::uint64_t size)
+{
+    std::vector<std::uint64_t> offsets {
+        header.ptr_mesh_movers,
+        header.ptr_sub1_0x18,
+        header.ptr_navpoints,
+        header.ptr_sub2_0x28,
+        header.ptr_layers,
+        header.ptr_htwk,
+        header.ptr_htwk_names,
+        header.ptr_images,
+        header.ptr_sub3_0x4C,
+        size,
+    };
+
+    for (std::uint32_t i = 0; i < objects.size(); i++) {
+        const auto object = objects[i];
+        offsets.push_back(object.ptr_0x8);
+        offsets.push_back(object.ptr_vertices_0xC);
+        offsets.push_back(object.ptr_indices_0x10);
+        offsets.push_back(object.ptr_0x14);
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+/* Names from the mesh movers that point at an object's info. */
+std::unordered_map<std::uint32_t, std::string> object_names(const unsigned char *data, std::uint64_t size, const P3DHeader &header, const std::string &name)
+{
+    std::unordered_map<std::uint32_t, std::string> names;
+
+    try {
+        const auto movers = read_table<P3DMeshMover>(data, size, header.ptr_mesh_movers, header.num_mesh_movers, "P3D", name, "mesh movers");
+        for (std::uint32_t i = 0; i < movers.size(); i++) {
+            const auto mover = movers[i];
+            if (auto object_name = read_string(data, size, mover.ptr_objname); !object_name.empty()) {
+                names.emplace(mover.ptr_objinfo, std::move(object_name));
+            }
+        }
+    }
+    catch (const ValidationError &e) {
+        spdlog::warn("{}", e.what());
+    }
+
+    return names;
+}
+
+void read_strips(Geometry &geometry, const unsigned char *data, std::uint64_t begin, std::uint64_t end)
+{
+    std::uint64_t offset = begin;
+
+    while (offset + kVertexRecordSize <= end) {
+        std::uint32_t count;
+        std::memcpy(&count, data + offset + 12, sizeof(count));
+
+        if (count == 0 || offset + count * kVertexRecordSize > end) {
+            break;
+        }
+
+        const auto first = static_cast<std::uint32_t>(geometry.positions.size() / 3);
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            float xyz[3];
+            std::memcpy(xyz, data + offset + i * kVertexRecordSize, sizeof(xyz));
+            geometry.positions.insert(geometry.positions.end(), xyz, xyz + 3);
+        }
+
+        /* Every other triangle of a strip is wound the other way. */
+        for (std::uint32_t i = 2; i < count; i++) {
+            const auto a = first + i - 2;
+            const auto b = first + i - 1;
+            const auto c = first + i;
+            if (i % 2) {
+                geometry.indices.insert(geometry.indices.end(), {b, a, c});
+            }
+            else {
+                geometry.indices.insert(geometry.indices.end(), {a, b, c});
+            }
+        }
+
+        offset += count * kVertexRecordSize;
+    }
+}
+
+}    // namespace
+
+Geometry read_geometry(const unsigned char *data, std::uint64_t size, const std::string &name)
+{
+    if (size < sizeof(P3DHeader)) {
+        throw ValidationError(fmt::format("P3D '{}': Smaller than its header", name));
+    }
+
+    P3DHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const auto objects = read_table<P3DObjInfo>(data, size, header.ptr_sub1_0x18, header.num_sub1_0x14, "P3D", name, "objects");
+    const auto offsets = known_offsets(header, objects, size);
+    const auto names = object_names(data, size, header, name);
+
+    Geometry geometry;
+    geometry.meshes.reserve(objects.size());
+
+    for (std::uint32_t i = 0; i < objects.size(); i++) {
+        const std::uint64_t begin = objects[i].ptr_vertices_0xC;
+        if (begin >= size) {
+            spdlog::warn("P3D '{}': Vertices of object {} are outside the file", name, i);
+            continue;
+        }
+
+        const auto end = *std::upper_bound(offsets.begin(), offsets.end(), begin);
+
+        MeshRange mesh;
+        const auto name_it = names.find(objects.offset_of(i));
+        mesh.name = name_it != names.end() ? name_it->second : fmt::format("object_{}", i);
+        mesh.first_vertex = static_cast<std::uint32_t>(geometry.positions.size() / 3);
+        mesh.first_index = static_cast<std::uint32_t>(geometry.indices.size());
+
+        read_strips(geometry, data, begin, end);
+
+        mesh.num_vertices = static_cast<std::uint32_t>(geometry.positions.size() / 3) - mesh.first_vertex;
+        mesh.num_indices = static_cast<std::uint32_t>(geometry.indices.size()) - mesh.first_index;
+        geometry.meshes.push_back(std::move(mesh));
+    }
+
+    return geometry;
+}
+
+void add_navpoints(Geometry &geometry, const unsigned char *data, std::uint64_t size, const std::string &name)
+{
+    if (size < sizeof(P3DHeader)) {
+        throw ValidationError(fmt::format("P3D '{}': Smaller than its header", name));
+    }
+
+    P3DHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const auto navpoints = read_table<P3DNavpoint>(data, size, header.ptr_navpoints, header.num_navpoints, "P3D", name, "navpoints");
+    for (std::uint32_t i = 0; i < navpoints.size(); i++) {
+        const auto navpoint = navpoints[i];
+        MeshRange mesh;
+        mesh.name = fmt::format("navpoint_{}", geometry.meshes.size());
+        mesh.first_vertex = static_cast<std::uint32_t>(geometry.positions.size() / 3);
+        mesh.num_vertices = 1;
+        mesh.first_index = static_cast<std::uint32_t>(geometry.indices.size());
+        geometry.positions.insert(geometry.positions.end(), {navpoint.x, navpoint.y, navpoint.z});
+        geometry.meshes.push_back(std::move(mesh));
+    }
+}
+
+Level read_level(const unsigned char *data, std::uint64_t size, const std::string &name)
+{
+    if (size < sizeof(P3DHeader)) {
+        throw ValidationError(fmt::format("P3D '{}': Smaller than its header", name));
+    }
+
+    P3DHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const StringBlock strings(data, size, header);
+
+    Level level;
+    level.position = {header.x, header.y, header.z};
+
+    std::vector<std::string> navpoint_names;
+    strings.for_each([&](const std::string &str) {
+        if (ends_with_tga(str)) {
+            level.images.push_back(str);
+        }
+        else if (is_navpoint_name(str)) {
+            navpoint_names.push_back(str);
+        }
+        else if (str.front() != '$') {
+            level.objects.push_back(str);
+        }
+    });
+
+    const auto navpoints = read_table<P3DNavpoint>(data, size, header.ptr_navpoints, header.num_navpoints, "P3D", name, "navpoints");
+    level.navpoints.reserve(navpoints.size());
+    for (std::uint32_t i = 0; i < navpoints.size(); i++) {
+        const auto navpoint = navpoints[i];
+        auto &out = level.navpoints.emplace_back();
+        if (i < navpoint_names.size()) {
+            out.name = navpoint_names[i];
+        }
+        out.position = {navpoint.x, navpoint.y, navpoint.z};
+        std::memcpy(&out.unk_0x0, navpoint.unk_0x0, sizeof(out.unk_0x0));
+        out.unk_0x4 = navpoint.unk_0x4;
+        out.unk_0x14 = navpoint.unk_0x14;
+        out.unk_0x24 = navpoint.unk_0x24;
+    }
+
+    const auto layers = read_table<P3DLayer>(data, size, header.ptr_layers, header.num_layers, "P3D", name, "layers");
+    for (std::uint32_t i = 0; i < layers.size(); i++) {
+        const auto layer = layers[i];
+        level.layers.push_back({strings.at(layer.layer_name), layer.num_objects, layer.ptr_0xC});
+    }
+
+    const auto movers = read_table<P3DMeshMover>(data, size, header.ptr_mesh_movers, header.num_mesh_movers, "P3D", name, "mesh movers");
+    for (std::uint32_t i = 0; i < movers.size(); i++) {
+        const auto mover = movers[i];
+        auto &out = level.mesh_movers.emplace_back();
+        out.name = strings.at(mover.ptr_objname);
+        out.position = {mover.vec[0], mover.vec[1], mover.vec[2]};
+        out.flags = mover.flags;
+
+        const auto relative = static_cast<std::int64_t>(mover.ptr_objinfo) - header.ptr_sub1_0x18;
+        if (relative >= 0 && relative % sizeof(P3DObjInfo) == 0 && relative / sizeof(P3DObjInfo) < header.num_sub1_0x14) {
+            out.object = static_cast<std::int32_t>(relative / sizeof(P3DObjInfo));
+        }
+    }
+
+    const auto htwks = read_table<P3DHTWK>(data, size, header.ptr_htwk, header.num_htwk, "P3D", name, "HTWK records");
+    const auto htwk_names = read_table<P3DHTWKName>(data, size, header.ptr_htwk_names, header.num_htwk, "P3D", name, "HTWK names");
+    level.htwks.reserve(htwks.size());
+    for (std::uint32_t i = 0; i < htwks.size(); i++) {
+        auto &out = level.htwks.emplace_back();
+        out.name = strings.at(htwk_names[i].ptr);
+        out.unk_0x0 = htwks[i].unk_0x0;
+        std::memcpy(out.values.data(), htwks.at(i) + offsetof(P3DHTWK, unk_0xC), sizeof(out.values));
+    }
+
+    return level;
+}
+
+}    // namespace ace3x::p3d
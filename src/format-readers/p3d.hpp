@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_READERS_P3D_HPP_
+#define ACE3X_FORMAT_READERS_P3D_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ace3x::p3d {
+
+/* One object's share of Geometry's buffers. An object without indices is a
+ * set of points, such as a navpoint. */
+struct MeshRange {
+    std::string name;
+    std::uint32_t first_vertex {0};
+    std::uint32_t num_vertices {0};
+    std::uint32_t first_index {0};
+    std::uint32_t num_indices {0};
+};
+
+/* Every object of a P3D in two flat buffers. */
+struct Geometry {
+    /* x, y, z per vertex. */
+    std::vector<float> positions;
+    /* Triangles, indexing positions of the whole geometry. */
+    std::vector<std::uint32_t> indices;
+    std::vector<MeshRange> meshes;
+};
+
+/* Reads the vertices of each P3DObjInfo.
+ *
+ * The vertices are runs of 16-byte records: x, y, z and w, where the w of a
+ * run's first record is the run's length. Each run is read as a triangle
+ * strip. A run may not extend past the next offset the file refers to,
+ * usually the object's ptr_indices_0x10, which is where reading stops.
+ *
+ * Throws ValidationError if the header or object table is out of bounds. */
+Geometry read_geometry(const unsigned char *data, std::uint64_t size, const std::string &name);
+
+/* Appends one point object per navpoint. */
+void add_navpoints(Geometry &geometry, const unsigned char *data, std::uint64_t size, const std::string &name);
+
+struct Navpoint {
+    /* The names are not linked to the navpoints. They are the '$player',
+     * '$npc' and '$hostile' strings, taken in file order, so may be wrong. */
+    std::string name;
+    std::array<float, 3> position {};
+    std::uint32_t unk_0x0 {0};
+    float unk_0x4 {0};
+    float unk_0x14 {0};
+    float unk_0x24 {0};
+};
+
+struct Layer {
+    std::string name;
+    std::uint32_t num_objects {0};
+    std::uint32_t ptr_0xC {0};
+};
+
+struct MeshMover {
+    std::string name;
+    std::array<float, 3> position {};
+    std::uint16_t flags {0};
+    /* Index into the P3DObjInfo table, -1 if it points elsewhere. */
+    std::int32_t object {-1};
+};
+
+struct Htwk {
+    std::string name;
+    std::uint32_t unk_0x0 {0};
+    std::array<float, 15> values {};
+};
+
+/* The tables the P3D viewer shows, for tools that work on level data. */
+struct Level {
+    std::array<float, 3> position {};
+    std::vector<Navpoint> navpoints;
+    std::vector<Layer> layers;
+    std::vector<MeshMover> mesh_movers;
+    std::vector<Htwk> htwks;
+    /* The .tga names from the string block. */
+    std::vector<std::string> images;
+    /* The other names from the string block, except those starting with '$'. */
+    std::vector<std::string> objects;
+};
+
+/* Names are only read from the string block between the header and the
+ * object table, so a wrong pointer gives an empty name rather than garbage.
+ * Throws ValidationError if a table is out of bounds. */
+Level read_level(const unsigned char *data, std::uint64_t size, const std::string &name);
+
+}    // namespace ace3x::p3d
+
+#endif    // ACE3X_FORMAT_READERS_P3D_HPP_
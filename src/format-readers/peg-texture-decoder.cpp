@@ -1,20 +1,32 @@
 /* SPDX-License-Identifier: GPLv3-or-later */
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
 enum FrameFormat {
+    PixelFormatAlpha8 = 0x2,
     PixelFormatRgba5551 = 0x3,
     PixelFormatRgba32 = 0x7,
     PixelFormatRgba5551Indexed = 0x104,    // gggrrrrr abbbbbgg
-    PixelFormat0x105 = 0x105,
+    PixelFormatRgba5551Indexed4 = 0x105,    // 4 bits per pixel, 16 entry palette
     PixelFormatRgba32Indexed = 0x204,
 };
 
 int munge_palette_index(int value);
 std::uint32_t components_to_argb(std::uint8_t a, std::uint8_t r, std::uint8_t g, std::uint8_t b);
 
+std::uint32_t rgba5551_to_argb(std::uint8_t b0, std::uint8_t b1)
+{
+    const auto r = (b0 & 0x1F) << 3u;
+    const auto g = (((b0 & 0xE0) >> 5u) | ((b1 & 0x3) << 3u)) << 3u;
+    const auto b = (b1 & 0x7C) << 1u;
+    const auto a = (b1 & 0x80) != 0 ? 0xFF : 0x00;
+
+    return components_to_argb(a, r, g, b);
+}
+
 void decode_rgba5551_indexed(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height)
 {
     static constexpr auto kPaletteEntrySize = 2;
@@ -24,20 +36,49 @@ void decode_rgba5551_indexed(std::uint32_t *dst, const unsigned char *const src,
     std::uint32_t palette[kNumPaletteEntries] = {0};
 
     for (auto i = 0u, o = 0u; i < kNumPaletteEntries; i++, o += 2u) {
-        const auto b0 = src[o + 0u];
-        const auto b1 = src[o + 1u];
+        palette[munge_palette_index(i)] = rgba5551_to_argb(src[o + 0u], src[o + 1u]);
+    }
 
-        const auto r = (b0 & 0x1F) << 3u;
-        const auto g = (((b0 & 0xE0) >> 5u) | ((b1 & 0x3) << 3u)) << 3u;
-        const auto b = (b1 & 0x7C) << 1u;
-        const auto a = (b1 & 0x80) != 0 ? 0xFF : 0x00;
+    const auto size = static_cast<std::size_t>(width) * height;
+    for (std::size_t i = 0; i < size; i++)
+        dst[i] = palette[src[kPaletteDataSize + i]];
+}
 
-        palette[munge_palette_index(i)] = components_to_argb(a, r, g, b);
+/* 16 entry palettes are small enough that the PS2 doesn't swizzle them,
+ * so there is no munge_palette_index here. Two pixels per byte, low nibble first. */
+void decode_rgba5551_indexed4(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height)
+{
+    static constexpr auto kPaletteEntrySize = 2;
+    static constexpr auto kNumPaletteEntries = 16;
+    static constexpr auto kPaletteDataSize = kNumPaletteEntries * kPaletteEntrySize;
+
+    std::uint32_t palette[kNumPaletteEntries] = {0};
+
+    for (auto i = 0u, o = 0u; i < kNumPaletteEntries; i++, o += 2u) {
+        palette[i] = rgba5551_to_argb(src[o + 0u], src[o + 1u]);
     }
 
-    const std::uint32_t size = width * height;
-    for (auto i = 0u; i < size; i++)
-        dst[i] = palette[src[kPaletteDataSize + i]];
+    const unsigned char *indices = src + kPaletteDataSize;
+    const auto size = static_cast<std::size_t>(width) * height;
+
+    for (std::size_t i = 0; i + 1u < size; i += 2u) {
+        const auto pair = indices[i / 2u];
+        dst[i + 0u] = palette[pair & 0xF];
+        dst[i + 1u] = palette[pair >> 4u];
+    }
+
+    if (size & 1u) {
+        dst[size - 1u] = palette[indices[size / 2u] & 0xF];
+    }
+}
+
+/* Alpha only. Shown as white so it is visible against the viewer background. */
+void decode_alpha8(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height)
+{
+    const auto size = static_cast<std::size_t>(width) * height;
+    for (std::size_t i = 0; i < size; i++) {
+        dst[i] = (static_cast<std::uint32_t>(src[i]) << 24u) | 0x00FFFFFFu;
+    }
 }
 
 void decode_rgba32_indexed(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height)
@@ -65,8 +106,8 @@ void decode_rgba32_indexed(std::uint32_t *dst, const unsigned char *const src, s
         palette[i] = palette_copy[munge_palette_index(i)];
     }
 
-    const std::uint32_t size = width * height;
-    for (auto i = 0u; i < size; i++) {
+    const auto size = static_cast<std::size_t>(width) * height;
+    for (std::size_t i = 0; i < size; i++) {
         dst[i] = palette[src[kPaletteDataSize + i]];
     }
 }
@@ -75,9 +116,9 @@ void decode_rgba32(std::uint32_t *dst, const unsigned char *const src, std::uint
 {
     unsigned char *d = reinterpret_cast<unsigned char *>(dst);
 
-    int size = width * height * 4;
+    const auto size = static_cast<std::size_t>(width) * height * 4u;
 
-    for (int i = 0; i < size; i += 4) {
+    for (std::size_t i = 0; i < size; i += 4) {
         d[i + 0] = src[i + 2];
         d[i + 1] = src[i + 1];
         d[i + 2] = src[i + 0];
@@ -89,9 +130,9 @@ void decode_rgba5551(std::uint32_t *dst, const unsigned char *const src, std::ui
 {
     unsigned char *d = reinterpret_cast<unsigned char *>(dst);
 
-    int size = width * height;
+    const auto size = static_cast<std::size_t>(width) * height;
 
-    for (int i = 0; i < size; i += 2) {
+    for (std::size_t i = 0; i < size; i += 2) {
         std::uint8_t r = src[i + 0] & 0x1F;
         std::uint8_t b = (src[i + 1] & 0x7C) >> 2;
 
@@ -107,10 +148,15 @@ void decode_rgba5551(std::uint32_t *dst, const unsigned char *const src, std::ui
 
 namespace ace3x::peg {
 
-void decode(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height, std::uint16_t format)
+bool decode(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height, std::uint16_t format)
 {
     switch (format) {
+        case PixelFormatAlpha8:
+            decode_alpha8(dst, src, width, height);
+            break;
         case PixelFormatRgba5551:
+            /* Only writes the first width * height bytes. */
+            std::fill(dst, dst + static_cast<std::size_t>(width) * height, 0);
             decode_rgba5551(dst, src, width, height);
             break;
         case PixelFormatRgba32:
@@ -119,11 +165,40 @@ void decode(std::uint32_t *dst, const unsigned char *const src, std::uint16_t wi
         case PixelFormatRgba5551Indexed:
             decode_rgba5551_indexed(dst, src, width, height);
             break;
+        case PixelFormatRgba5551Indexed4:
+            decode_rgba5551_indexed4(dst, src, width, height);
+            break;
         case PixelFormatRgba32Indexed:
             decode_rgba32_indexed(dst, src, width, height);
             break;
         default:
-            break;
+            std::fill(dst, dst + static_cast<std::size_t>(width) * height, 0);
+            return false;
+    }
+
+    return true;
+}
+
+std::uint64_t payload_size(std::uint16_t format, std::uint16_t width, std::uint16_t height)
+{
+    const auto pixels = static_cast<std::uint64_t>(width) * height;
+
+    switch (format) {
+        case PixelFormatAlpha8:
+            return pixels;
+        case PixelFormatRgba5551:
+            /* decode_rgba5551 reads pixel pairs. */
+            return (pixels + 1u) & ~std::uint64_t {1};
+        case PixelFormatRgba32:
+            return pixels * 4u;
+        case PixelFormatRgba5551Indexed:
+            return 256u * 2u + pixels;
+        case PixelFormatRgba5551Indexed4:
+            return 16u * 2u + (pixels + 1u) / 2u;
+        case PixelFormatRgba32Indexed:
+            return 256u * 4u + pixels;
+        default:
+            return 0;
     }
 }
 
@@ -7,7 +7,12 @@
 
 namespace ace3x::peg {
 
-void decode(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height, std::uint16_t format);
+/* Writes every one of the width * height pixels in dst, so callers need not clear it.
+ * Returns false if the format is unknown, in which case dst is zero-filled. */
+bool decode(std::uint32_t *dst, const unsigned char *const src, std::uint16_t width, std::uint16_t height, std::uint16_t format);
+
+/* Number of bytes of src that decode reads, palette included. 0 for unknown formats. */
+std::uint64_t payload_size(std::uint16_t format, std::uint16_t width, std::uint16_t height);
 
 }
 
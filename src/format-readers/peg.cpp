@@ -3,6 +3,8 @@
 #include <spdlog/spdlog.h>
 
 #include <QLocale>
+#include <cstddef>
+#include <cstring>
 
 #include "format-readers/peg-texture-decoder.hpp"
 #include "format-readers/validation-error.hpp"
@@ -70,49 +72,72 @@ std::vector<ArchiveEntry> read_entries(const unsigned char *const data, const st
     return entries;
 }
 
-std::vector<Image> get_images(const unsigned char *const data)
+FrameInfo get_frame_info(const unsigned char *const data, std::uint32_t index)
 {
-    PegHeader header;
-    std::memcpy(&header, data, sizeof(PegHeader));
+    const unsigned char *frame_data = &data[sizeof(PegHeader) + sizeof(PegFrame) * index];
 
-    const std::uint32_t headerTotalSize = sizeof(PegHeader) + header.textureHeaderSize;
+    PegFrame frame;
+    std::memcpy(&frame, frame_data, sizeof(PegFrame));
 
-    std::vector<PegFrame> frames(header.textureCount);
+    const char *filename = reinterpret_cast<const char *>(frame_data + offsetof(PegFrame, filename));
 
-    std::memcpy(frames.data(), &data[sizeof(PegHeader)], sizeof(PegFrame) * header.textureCount);
+    FrameInfo info;
+    info.filename = std::string_view(filename, strnlen(filename, sizeof(frame.filename)));
+    info.width = frame.width;
+    info.height = frame.height;
+    info.format = frame.format;
+    info.offset = frame.offset;
 
-    auto GetFrameSize = [&](std::uint64_t frameIndex) -> std::uint32_t {
-        std::uint32_t frameEnd = 0;
+    return info;
+}
 
-        if (frameIndex + 1 >= header.textureCount)
-            frameEnd = headerTotalSize + header.dataSize;
-        else
-            frameEnd = frames[frameIndex + 1].offset;
+Image get_image(const unsigned char *const data, std::uint64_t size, std::uint32_t index)
+{
+    if (size < sizeof(PegHeader)) {
+        return {};
+    }
 
-        return frameEnd - frames[frameIndex].offset;
-    };
+    PegHeader header;
+    std::memcpy(&header, data, sizeof(PegHeader));
 
-    std::vector<std::uint32_t> sizes(header.textureCount);
-    for (std::uint32_t i = 0; i < header.textureCount; i++)
-        sizes[i] = GetFrameSize(i);
+    if (index >= header.textureCount || sizeof(PegHeader) + sizeof(PegFrame) * (static_cast<std::uint64_t>(index) + 1) > size) {
+        return {};
+    }
 
-    std::vector<Image> images;
+    const auto info = get_frame_info(data, index);
 
-    for (auto i = 0u; i < header.textureCount; i++) {
-        const auto &frame {frames[i]};
+    if (info.offset + ace3x::peg::payload_size(info.format, info.width, info.height) > size) {
+        spdlog::warn("PEG: Frame {} '{}' exceeds the PEG", index, info.filename);
+        return {};
+    }
+
+    Image image;
+    image.width = info.width;
+    image.height = info.height;
+    image.filename = std::string(info.filename);
+    image.format = info.format;
+
+    image.pixels.resize(static_cast<std::uint64_t>(info.width) * static_cast<uint64_t>(info.height));
 
-        Image image;
-        image.width = frame.width;
-        image.height = frame.height;
-        image.filename = frame.filename;
-        image.format = frame.format;
+    ace3x::peg::decode(image.pixels.data(), data + info.offset, info.width, info.height, info.format);
 
-        image.pixels.resize(static_cast<std::uint64_t>(frame.width) * static_cast<uint64_t>(frame.height));
-        std::fill(image.pixels.begin(), image.pixels.end(), 0);
+    return image;
+}
 
-        ace3x::peg::decode(image.pixels.data(), reinterpret_cast<const unsigned char *>(data + frame.offset), frame.width, frame.height, frame.format);
+std::vector<Image> get_images(const unsigned char *const data, std::uint64_t size)
+{
+    if (size < sizeof(PegHeader)) {
+        return {};
+    }
 
-        images.push_back(image);
+    PegHeader header;
+    std::memcpy(&header, data, sizeof(PegHeader));
+
+    std::vector<Image> images;
+    images.reserve(header.textureCount);
+
+    for (auto i = 0u; i < header.textureCount; i++) {
+        images.push_back(get_image(data, size, i));
     }
 
     return images;
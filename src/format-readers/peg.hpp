@@ -1,23 +1,65 @@
 #ifndef ACE3X_FORMAT_READERS_PEG_HPP_
 #define ACE3X_FORMAT_READERS_PEG_HPP_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "format-readers/archive-entry.hpp"
 
 namespace ace3x::peg {
 
-struct Image {
-    std::string filename;
-    std::vector<std::uint32_t> pixels;
+/* Default-initialises on resize() instead of zeroing, since peg::decode
+ * overwrites every pixel anyway. */
+template <typename T>
+struct UninitializedAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = UninitializedAllocator<U>;
+    };
+
+    using std::allocator<T>::allocator;
+
+    template <typename U>
+    void construct(U *ptr)
+    {
+        ::new (static_cast<void *>(ptr)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *ptr, Args &&... args)
+    {
+        ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...);
+    }
+};
+
+using PixelBuffer = std::vector<std::uint32_t, UninitializedAllocator<std::uint32_t>>;
+
+/* Header of one frame, with the name pointing into the PEG data. */
+struct FrameInfo {
+    std::string_view filename;
     int width;
     int height;
     std::uint16_t format;
+    std::uint32_t offset;
+};
+
+struct Image {
+    std::string filename;
+    PixelBuffer pixels;
+    int width {0};
+    int height {0};
+    std::uint16_t format {0};
 };
 
 std::vector<ArchiveEntry> read_entries(const unsigned char *const data, const std::string &peg_name);
-std::vector<Image> get_images(const unsigned char *const data);
+FrameInfo get_frame_info(const unsigned char *const data, std::uint32_t index);
+/* Returns an empty Image if index is not a frame of the PEG, or its pixels
+ * don't fit in the size bytes of it. */
+Image get_image(const unsigned char *const data, std::uint64_t size, std::uint32_t index);
+std::vector<Image> get_images(const unsigned char *const data, std::uint64_t size);
 
 }    // namespace ace3x::peg
 
@@ -0,0 +1,280 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-readers/registry.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "format-readers/peg.hpp"
+#include "format-readers/validation-error.hpp"
+#include "format-readers/vim.hpp"
+#include "format-readers/vpp.hpp"
+#include "formats/peg.hpp"
+#include "formats/vf2.hpp"
+#include "formats/vpp.hpp"
+
+namespace ace3x {
+
+namespace {
+
+/* Defaults for formats without a signature or children. A specialisation
+ * shadows them by declaring static functions of the same name. */
+struct NoTraits {
+    /* First four bytes, if they are unique to the format. 0 if not. */
+    static constexpr std::uint32_t magic {0};
+    static constexpr SignatureFn matches {nullptr};
+    static constexpr ChildrenFn children {nullptr};
+};
+
+/* Everything known about one format. Every FormatId needs a specialisation,
+ * or building the table below fails to compile. */
+template <FormatId Id>
+struct FormatTraits;
+
+template <>
+struct FormatTraits<FormatId::Unknown> : NoTraits {
+    static constexpr std::string_view name {"Unknown"};
+    static constexpr std::array<std::string_view, 0> extensions {};
+};
+
+template <>
+struct FormatTraits<FormatId::Vpp> : NoTraits {
+    static constexpr std::string_view name {"VPP archive"};
+    static constexpr std::array<std::string_view, 1> extensions {".vpp"};
+    static constexpr std::uint32_t magic {0x51890ACE};
+
+    static bool matches(const unsigned char* data, std::uint64_t size)
+    {
+        if (size < sizeof(VppV2Header)) {
+            return false;
+        }
+
+        std::uint32_t signature;
+        std::memcpy(&signature, data, sizeof(signature));
+        return signature == magic;
+    }
+
+    /* Only for VPPs nested in other containers. Top-level archives are read by
+     * the VFS, which maps and decompresses them first. */
+    static std::vector<ArchiveEntry> children(const unsigned char* data, std::uint64_t size, const std::string& name)
+    {
+        const auto info = vpp::read_info(data, name);
+
+        if (info.compressed) {
+            spdlog::warn("Registry: '{}' is compressed, not listing its entries", name);
+            return {};
+        }
+
+        return vpp::read_entries(info, size);
+    }
+};
+
+template <>
+struct FormatTraits<FormatId::Peg> : NoTraits {
+    static constexpr std::string_view name {"PEG texture"};
+    static constexpr std::array<std::string_view, 1> extensions {".peg"};
+    static constexpr std::uint32_t magic {0x564B4547};
+
+    static bool matches(const unsigned char* data, std::uint64_t size)
+    {
+        if (size < sizeof(PegHeader)) {
+            return false;
+        }
+
+        std::uint32_t signature;
+        std::memcpy(&signature, data, sizeof(signature));
+        return signature == magic;
+    }
+
+    static std::vector<ArchiveEntry> children(const unsigned char* data, std::uint64_t size, const std::string& name)
+    {
+        if (size < sizeof(PegHeader)) {
+            throw ValidationError(fmt::format("PEG '{}': Smaller than its header", name));
+        }
+
+        PegHeader header;
+        std::memcpy(&header, data, sizeof(PegHeader));
+
+        if (sizeof(PegHeader) + static_cast<std::uint64_t>(header.textureCount) * sizeof(PegFrame) > size) {
+            throw ValidationError(fmt::format("PEG '{}': Frame table exceeds PEG size", name));
+        }
+
+        return peg::read_entries(data, name);
+    }
+};
+
+template <>
+struct FormatTraits<FormatId::Tga> : NoTraits {
+    static constexpr std::string_view name {"PEG frame"};
+    static constexpr std::array<std::string_view, 1> extensions {".tga"};
+};
+
+template <>
+struct FormatTraits<FormatId::Vbm> : NoTraits {
+    static constexpr std::string_view name {"VBM animation"};
+    static constexpr std::array<std::string_view, 1> extensions {".vbm"};
+};
+
+template <>
+struct FormatTraits<FormatId::Tbl> : NoTraits {
+    static constexpr std::string_view name {"Table"};
+    static constexpr std::array<std::string_view, 1> extensions {".tbl"};
+};
+
+template <>
+struct FormatTraits<FormatId::Arr> : NoTraits {
+    static constexpr std::string_view name {"Array"};
+    static constexpr std::array<std::string_view, 1> extensions {".arr"};
+};
+
+template <>
+struct FormatTraits<FormatId::Vim> : NoTraits {
+    static constexpr std::string_view name {"VIM mesh"};
+    static constexpr std::array<std::string_view, 1> extensions {".vim"};
+
+    /* Only a version word, too common to identify a VIM on its own, but
+     * enough to reject a file that is named like one. */
+    static bool matches(const unsigned char* data, std::uint64_t size)
+    {
+        if (size < 0x20) {
+            return false;
+        }
+
+        std::uint32_t version;
+        std::memcpy(&version, data, sizeof(version));
+        return version == ace3x::vim::kVersion;
+    }
+};
+
+template <>
+struct FormatTraits<FormatId::P3d> : NoTraits {
+    static constexpr std::string_view name {"P3D scene"};
+    static constexpr std::array<std::string_view, 1> extensions {".p3d"};
+};
+
+template <>
+struct FormatTraits<FormatId::Vf2> : NoTraits {
+    static constexpr std::string_view name {"VF2 font"};
+    static constexpr std::array<std::string_view, 1> extensions {".vf2"};
+    static constexpr std::uint32_t magic {VF_SIGNATURE};
+
+    static bool matches(const unsigned char* data, std::uint64_t size)
+    {
+        /* The rest of the header depends on the version. */
+        if (size < 2 * sizeof(std::uint32_t)) {
+            return false;
+        }
+
+        std::uint32_t signature;
+        std::memcpy(&signature, data, sizeof(signature));
+        return signature == magic;
+    }
+};
+
+template <std::size_t... Ids>
+constexpr std::array<FormatInfo, kFormatCount> make_table(std::index_sequence<Ids...>)
+{
+    return {{{static_cast<FormatId>(Ids),
+              FormatTraits<static_cast<FormatId>(Ids)>::name,
+              FormatTraits<static_cast<FormatId>(Ids)>::matches,
+              FormatTraits<static_cast<FormatId>(Ids)>::children}...}};
+}
+
+constexpr auto kFormats = make_table(std::make_index_sequence<kFormatCount> {});
+
+struct ExtensionMapping {
+    std::string_view extension;
+    FormatId id;
+};
+
+template <FormatId Id>
+constexpr void add_extensions(std::array<ExtensionMapping, 16>& mappings, std::size_t& count)
+{
+    for (const auto extension : FormatTraits<Id>::extensions) {
+        mappings[count++] = {extension, Id};
+    }
+}
+
+template <std::size_t... Ids>
+constexpr std::pair<std::array<ExtensionMapping, 16>, std::size_t> make_extensions(std::index_sequence<Ids...>)
+{
+    std::array<ExtensionMapping, 16> mappings {};
+    std::size_t count {0};
+    (add_extensions<static_cast<FormatId>(Ids)>(mappings, count), ...);
+    return {mappings, count};
+}
+
+constexpr auto kExtensions = make_extensions(std::make_index_sequence<kFormatCount> {});
+
+struct MagicMapping {
+    std::uint32_t magic;
+    FormatId id;
+};
+
+template <FormatId Id>
+constexpr void add_magic(std::array<MagicMapping, kFormatCount>& mappings, std::size_t& count)
+{
+    if (FormatTraits<Id>::magic) {
+        mappings[count++] = {FormatTraits<Id>::magic, Id};
+    }
+}
+
+template <std::size_t... Ids>
+constexpr std::pair<std::array<MagicMapping, kFormatCount>, std::size_t> make_magics(std::index_sequence<Ids...>)
+{
+    std::array<MagicMapping, kFormatCount> mappings {};
+    std::size_t count {0};
+    (add_magic<static_cast<FormatId>(Ids)>(mappings, count), ...);
+    return {mappings, count};
+}
+
+/* Only a handful, so a linear scan compiles to a few compares of one word. */
+constexpr auto kMagics = make_magics(std::make_index_sequence<kFormatCount> {});
+
+}    // namespace
+
+const FormatInfo& format_info(FormatId id)
+{
+    return kFormats[static_cast<std::size_t>(id) < kFormatCount ? static_cast<std::size_t>(id) : 0];
+}
+
+FormatId format_from_extension(std::string_view extension)
+{
+    for (std::size_t i = 0; i < kExtensions.second; i++) {
+        if (kExtensions.first[i].extension == extension) {
+            return kExtensions.first[i].id;
+        }
+    }
+
+    return FormatId::Unknown;
+}
+
+FormatId sniff_format(const unsigned char* data, std::uint64_t size, FormatId hint)
+{
+    if (data && size >= sizeof(std::uint32_t)) {
+        std::uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+
+        for (std::size_t i = 0; i < kMagics.second; i++) {
+            if (kMagics.first[i].magic == word) {
+                const auto& info = format_info(kMagics.first[i].id);
+                if (info.matches(data, size)) {
+                    return info.id;
+                }
+            }
+        }
+    }
+
+    /* Named like a format it is not, e.g. a truncated PEG. */
+    const auto& hinted = format_info(hint);
+    if (hinted.matches && !(data && hinted.matches(data, size))) {
+        return FormatId::Unknown;
+    }
+
+    return hint;
+}
+
+}    // namespace ace3x
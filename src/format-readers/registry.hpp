@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_READERS_REGISTRY_HPP_
+#define ACE3X_FORMAT_READERS_REGISTRY_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format-readers/archive-entry.hpp"
+#include "format-readers/format-id.hpp"
+
+namespace ace3x {
+
+/* Whether data starts with the format's signature. */
+using SignatureFn = bool (*)(const unsigned char* data, std::uint64_t size);
+/* Entries nested in a container, with offsets relative to data.
+ * Throws ValidationError if the container is malformed. */
+using ChildrenFn = std::vector<ArchiveEntry> (*)(const unsigned char* data, std::uint64_t size, const std::string& name);
+
+struct FormatInfo {
+    FormatId id;
+    std::string_view name;
+    /* nullptr if the format has no signature. */
+    SignatureFn matches;
+    /* nullptr if the format is not a container. */
+    ChildrenFn children;
+};
+
+/* One entry per FormatId, filled in from the FormatTraits specialisations in
+ * registry.cpp, so dispatch is an array index. */
+const FormatInfo& format_info(FormatId id);
+
+/* Resolves a lowercase extension such as ".peg". Meant to be called once per
+ * entry when it is loaded; everything after that dispatches on the FormatId. */
+FormatId format_from_extension(std::string_view extension);
+
+/* Identifies data by its first bytes. Formats with a unique signature are
+ * recognised whatever the hint says; otherwise the hint, usually from the
+ * extension, is kept unless its format has a signature that does not match,
+ * in which case the data is Unknown. Reads at most the format's header. */
+FormatId sniff_format(const unsigned char* data, std::uint64_t size, FormatId hint);
+
+}    // namespace ace3x
+
+#endif    // ACE3X_FORMAT_READERS_REGISTRY_HPP_
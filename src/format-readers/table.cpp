@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-readers/table.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include "format-readers/validation-error.hpp"
+
+namespace ace3x {
+
+void throw_out_of_bounds(std::string_view format, std::string_view name, std::uint32_t count, const char *what, std::uint32_t offset)
+{
+    throw ValidationError(fmt::format("{} '{}': {} {} at 0x{:x} exceed the file", format, name, count, what, offset));
+}
+
+}    // namespace ace3x
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_READERS_TABLE_HPP_
+#define ACE3X_FORMAT_READERS_TABLE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace ace3x {
+
+/* A table of T in the mapped file. Nothing is copied up front. Items, or
+ * single fields of them, are copied out on access since the tables are not
+ * aligned. */
+template <typename T>
+class Table {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    Table() = default;
+
+    Table(const unsigned char *base, std::uint32_t offset, std::uint32_t count)
+        : base_(base)
+        , offset_(offset)
+        , count_(count)
+    {
+    }
+
+    std::uint32_t size() const
+    {
+        return count_;
+    }
+
+    bool empty() const
+    {
+        return count_ == 0;
+    }
+
+    T operator[](std::uint32_t index) const
+    {
+        T item;
+        std::memcpy(&item, at(index), sizeof(T));
+        return item;
+    }
+
+    /* The bytes of an item. */
+    const unsigned char *at(std::uint32_t index) const
+    {
+        return base_ + offset_of(index);
+    }
+
+    /* Offset of an item from the start of the file. */
+    std::uint32_t offset_of(std::uint32_t index) const
+    {
+        return offset_ + index * static_cast<std::uint32_t>(sizeof(T));
+    }
+
+private:
+    const unsigned char *base_ {nullptr};
+    std::uint32_t offset_ {0};
+    std::uint32_t count_ {0};
+};
+
+[[noreturn]] void throw_out_of_bounds(std::string_view format, std::string_view name, std::uint32_t count, const char *what, std::uint32_t offset);
+
+/* Throws ValidationError, naming the file as "<format> '<name>'", if the
+ * table does not fit in the file. */
+template <typename T>
+Table<T> read_table(const unsigned char *data, std::uint64_t size, std::uint32_t offset, std::uint32_t count, std::string_view format, std::string_view name, const char *what)
+{
+    if (offset + static_cast<std::uint64_t>(count) * sizeof(T) > size) {
+        throw_out_of_bounds(format, name, count, what, offset);
+    }
+
+    return {data, offset, count};
+}
+
+}    // namespace ace3x
+
+#endif    // ACE3X_FORMAT_READERS_TABLE_HPP_
@@ -1,4 +1,181 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
 #include "format-readers/vf2.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "format-readers/validation-error.hpp"
+
 namespace ace3x::vf2 {
+
+namespace {
+
+bool kerning_indices_valid(const Font& font)
+{
+    for (const auto& c : font.chars) {
+        if (c.first_kerning_entry != 0xFFFF && c.first_kerning_entry >= font.kerning_pairs.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* The descriptors of fonts with no kerning pairs end in 0xFFFF, which no other
+ * 32-bit field in the tables holds. Used when the documented layout doesn't
+ * fit, as the exact header of Summoner fonts is not known for every version. */
+std::uint64_t find_chars_by_sentinel(const unsigned char* data, std::uint64_t size)
+{
+    for (std::uint64_t offset = sizeof(Vf2Header); offset + sizeof(std::uint32_t) <= size; offset += sizeof(std::uint32_t)) {
+        std::uint32_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        if (value == 0xFFFF) {
+            return offset - offsetof(Vf2CharDescriptor, first_kerning_entry);
+        }
+    }
+
+    return size;
 }
+
+}    // namespace
+
+Font read(const unsigned char* data, std::uint64_t size, const std::string& name)
+{
+    Font font;
+    std::uint64_t offset {0};
+
+    auto read_u32 = [&]() {
+        if (offset + sizeof(std::uint32_t) > size) {
+            throw ValidationError(fmt::format("VF2 '{}': Header is truncated", name));
+        }
+        std::uint32_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        offset += sizeof(value);
+        return value;
+    };
+
+    auto& header = font.header;
+
+    header.signature = read_u32();
+    if (header.signature != VF_SIGNATURE) {
+        throw ValidationError(fmt::format("VF2 '{}': Signature mismatch 0x{:08x} != 0x{:08x}", name, header.signature, VF_SIGNATURE));
+    }
+
+    header.version = read_u32();
+    header.format = header.version >= 1 ? read_u32() : VfFormatMono4;
+    header.num_chars = read_u32();
+    header.first_ascii = read_u32();
+    header.default_spacing = read_u32();
+    header.height = read_u32();
+    header.num_kern_pairs = read_u32();
+    if (header.version == 0) {
+        header.kern_data_size = read_u32();
+        header.char_data_size = read_u32();
+    }
+    header.pixel_data_size = read_u32();
+
+    const std::uint64_t kerning_size = static_cast<std::uint64_t>(header.num_kern_pairs) * sizeof(Vf2KerningPair);
+    const std::uint64_t chars_size = static_cast<std::uint64_t>(header.num_chars) * sizeof(Vf2CharDescriptor);
+
+    if (offset + kerning_size <= size) {
+        font.kerning_pairs.resize(header.num_kern_pairs);
+        std::memcpy(font.kerning_pairs.data(), data + offset, kerning_size);
+    }
+
+    std::uint64_t chars_offset = offset + kerning_size;
+
+    if (chars_offset + chars_size <= size) {
+        font.chars.resize(header.num_chars);
+        std::memcpy(font.chars.data(), data + chars_offset, chars_size);
+    }
+
+    if (font.chars.size() != header.num_chars || !kerning_indices_valid(font)) {
+        chars_offset = find_chars_by_sentinel(data, size);
+
+        if (chars_offset < offset || chars_offset + chars_size > size) {
+            throw ValidationError(fmt::format("VF2 '{}': {} character descriptors don't fit in {} bytes", name, header.num_chars, size));
+        }
+
+        spdlog::debug("VF2: '{}': Characters found at 0x{:x} instead of 0x{:x}", name, chars_offset, offset + kerning_size);
+
+        if (offset + kerning_size > chars_offset) {
+            font.kerning_pairs.clear();
+        }
+        font.chars.resize(header.num_chars);
+        std::memcpy(font.chars.data(), data + chars_offset, chars_size);
+    }
+
+    const std::uint64_t pixels_offset = chars_offset + chars_size;
+    if (header.pixel_data_size && pixels_offset + header.pixel_data_size <= size) {
+        font.pixels = data + pixels_offset;
+    }
+
+    return font;
+}
+
+KerningTable::KerningTable()
+    : offsets_(kMaxChars * kMaxChars, 0)
+{
+}
+
+KerningTable::KerningTable(const Font& font)
+    : KerningTable()
+{
+    for (const auto& pair : font.kerning_pairs) {
+        offsets_[pair.char_before_idx * kMaxChars + pair.char_after_idx] = pair.offset;
+    }
+}
+
+TextExtent layout(const Font& font, const KerningTable& kerning, const std::uint16_t* text, std::size_t length, std::vector<PlacedGlyph>& placed)
+{
+    placed.clear();
+    placed.reserve(length);
+
+    const auto& header = font.header;
+    const int line_height = static_cast<int>(header.height);
+    const auto num_chars = static_cast<std::uint32_t>(font.chars.size());
+
+    /* Unsigned, so characters below first_ascii wrap around to missing too. */
+    auto char_index = [&](std::size_t i) {
+        return static_cast<std::uint32_t>(text[i]) - header.first_ascii;
+    };
+
+    TextExtent extent;
+    int x {0};
+    int y {0};
+
+    for (std::size_t i = 0; i < length; i++) {
+        if (text[i] == '\n') {
+            x = 0;
+            y += line_height;
+            continue;
+        }
+
+        const auto index = char_index(i);
+
+        if (index >= num_chars) {
+            x += static_cast<int>(header.default_spacing);
+            continue;
+        }
+
+        const auto& c = font.chars[index];
+
+        placed.push_back({index, x, y});
+        extent.width = std::max(extent.width, x + static_cast<int>(std::max(c.width, c.spacing)));
+
+        x += static_cast<int>(c.spacing);
+        if (i + 1 < length) {
+            x += kerning.offset(index, char_index(i + 1));
+        }
+    }
+
+    extent.height = length ? y + line_height : 0;
+
+    return extent;
+}
+
+}    // namespace ace3x::vf2
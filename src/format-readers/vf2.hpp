@@ -1,8 +1,67 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
 #ifndef ACE3X_FORMAT_READERS_VF2_HPP_
 #define ACE3X_FORMAT_READERS_VF2_HPP_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "formats/vf2.hpp"
+
 namespace ace3x::vf2 {
-void load_vf2();
-}
+
+struct Font {
+    /* Fields a version does not have are left 0, format defaults to VfFormatMono4. */
+    Vf2Header header {};
+    std::vector<Vf2KerningPair> kerning_pairs;
+    std::vector<Vf2CharDescriptor> chars;
+    /* Points into the VF2 data, nullptr if the file has no pixel data. Summoner
+     * fonts keep their glyphs in a VBM instead. */
+    const unsigned char* pixels {nullptr};
+};
+
+/* Parses the header, kerning pairs and character descriptors. The header is
+ * read field by field since its size depends on the version.
+ *
+ * Throws ValidationError if the signature is wrong or the tables don't fit. */
+Font read(const unsigned char* data, std::uint64_t size, const std::string& name);
+
+/* Spacing adjustments of the kerning pairs by [before][after] character index.
+ * The pairs use 8-bit indices, so the dense table is 64 KiB and a lookup is a
+ * single load instead of a walk from Vf2CharDescriptor::first_kerning_entry. */
+class KerningTable {
+public:
+    KerningTable();
+    explicit KerningTable(const Font& font);
+
+    int offset(std::uint32_t before, std::uint32_t after) const
+    {
+        return (before < kMaxChars && after < kMaxChars) ? offsets_[before * kMaxChars + after] : 0;
+    }
+
+private:
+    static constexpr std::uint32_t kMaxChars {256};
+    std::vector<std::int8_t> offsets_;
+};
+
+struct PlacedGlyph {
+    std::uint32_t index;    // into Font::chars
+    int x;
+    int y;
+};
+
+struct TextExtent {
+    int width {0};
+    int height {0};
+};
+
+/* Lays out UTF-16 text in one pass. Each character advances by its spacing
+ * plus the kerning with the next one, '\n' starts a new line, and characters
+ * the font lacks advance by its default spacing. placed is cleared and
+ * refilled, so passing the same vector each time avoids reallocating. */
+TextExtent layout(const Font& font, const KerningTable& kerning, const std::uint16_t* text, std::size_t length, std::vector<PlacedGlyph>& placed);
+
+}    // namespace ace3x::vf2
 
 #endif    // ACE3X_FORMAT_READERS_VF2_HPP_
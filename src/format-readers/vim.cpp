@@ -4,129 +4,110 @@
 
 #include <spdlog/spdlog.h>
 
-#include <cassert>
-#include <cstdio>
 #include <cstring>
 
-#include "formats/vim.hpp"
+#include "format-readers/validation-error.hpp"
 
-char **allocate_filenames(const char *buffer, int count, int &totalSize);
+namespace ace3x::vim {
 
-VifMesh::~VifMesh()
+namespace {
+
+constexpr std::uint32_t kNamesOffset {0x20};
+
+/* sub0 to num_0x68 */
+constexpr std::uint32_t kTableHeaderSize {48};
+
+std::uint32_t read_u32(const unsigned char *data, std::uint64_t offset)
 {
-    if (textureNames_0x20_) {
-        for (auto i = 0u; i < numTextures_0x1c_; i++)
-            delete[] textureNames_0x20_[i];
-        delete[] textureNames_0x20_;
-    }
+    std::uint32_t value;
+    std::memcpy(&value, data + offset, sizeof(value));
+    return value;
 }
 
-void VifMesh::read(const unsigned char *buffer)
+/* The offset after a run of bytes equal to (or, with equal false, other than)
+ * value, or size if the run reaches the end. */
+std::uint64_t skip(const unsigned char *data, std::uint64_t size, std::uint64_t offset, unsigned char value, bool equal)
 {
-    assert(buffer);
-
-    if (textureNames_0x20_) {
-        for (auto i = 0u; i < numTextures_0x1c_; i++)
-            delete[] textureNames_0x20_[i];
-        delete[] textureNames_0x20_;
+    while (offset < size && (data[offset] == value) == equal) {
+        offset++;
     }
-    //        if (vim.rtTextureHandles_0x24)
-    //                delete[] vim.rtTextureHandles_0x24;
-
-    spdlog::debug("==== VIM::HEADER ====");
-
-    // Copy first 0x20 bytes, stop before filenames
-    memcpy(&version_0x0_, buffer, 4);
-    memcpy(&flags_0x4_, buffer + 4, 4);
-    memcpy(&field_0x8_, buffer + 8, 4);
-    memcpy(&field_0xc_, buffer + 12, 4);
-    memcpy(&field_0x10_, buffer + 16, 4);
-    memcpy(&field_0x14_, buffer + 20, 4);
-    memcpy(&field_0x18_, buffer + 24, 4);
-    memcpy(&numTextures_0x1c_, buffer + 28, 4);
-
-    spdlog::debug("VIM: Version: %04X", version_0x0_);
-    spdlog::debug("VIM: Flags: %04X", flags_0x4_);
-
-    assert(version_0x0_ == 0xB);
-
-    spdlog::debug("==== VIM::FILENAMES ====");
-    spdlog::debug("VIM: Copying filenames...");
-
-    int totalFilenamesSize = 0;
-    textureNames_0x20_ = allocate_filenames(reinterpret_cast<const char *>(buffer), numTextures_0x1c_, totalFilenamesSize);
-
-    spdlog::debug("VIM: Copied {} filenames of total size {:02x} ({})", numTextures_0x1c_, totalFilenamesSize, totalFilenamesSize);
-
-    spdlog::debug("==== VIM::DATA ====");
-
-    spdlog::debug("Allocating space for texture {} handles...", numTextures_0x1c_);
-    rtTextureHandles_0x24_ = new uint32_t[numTextures_0x1c_];
-
-    int filenamesStart = 0x20;
-
-    // Seek to 0xFF
-    auto *ptr = buffer + totalFilenamesSize + filenamesStart;
-    while (((*ptr) & 0xFF) != 0xFF)
-        ptr++;
-
-    spdlog::debug("Buffer {:p} data {:p}, offset from start = {:td}", (void *)buffer, (void *)ptr, reinterpret_cast<intptr_t>(ptr) - reinterpret_cast<intptr_t>(buffer));
+    return offset;
+}
 
-    // Seek past 0xFF's
-    while (((*ptr) & 0xFF) == 0xFF)
-        ptr++;
-    ptr += 4;
+}    // namespace
 
-    memcpy(&sub0_count_, ptr, 4);
-    memcpy(&sub0_data_, ptr + 4, 4);
-    memcpy(&vifBone_count_, ptr + 8, 4);
-    memcpy(&vifBone_data_, ptr + 12, 4);
-    memcpy(&field_0x4C_, ptr + 16, 4);
-    memcpy(&sub4_count_, ptr + 20, 4);
-    memcpy(&sub4_data_, ptr + 24, 4);
-    memcpy(&field_0x58_, ptr + 28, 4);
-    memcpy(&sub5_count_, ptr + 32, 4);
-    memcpy(&sub5_data_, ptr + 36, 4);
-    memcpy(&data_0x64_, ptr + 40, 4);
-    memcpy(&num_0x68_, ptr + 44, 4);
+std::string_view Mesh::string_at(std::uint32_t offset) const
+{
+    if (offset >= size) {
+        return {};
+    }
 
-    fflush(stdout);
+    const auto *str = reinterpret_cast<const char *>(data + offset);
+    return {str, strnlen(str, size - offset)};
 }
 
-char **allocate_filenames(const char *buffer, int count, int &totalSize)
+Table<VifMeshSub1> Mesh::sub1(const VifMeshSub0 &sub0) const
 {
-    int filenameSize = 0;
-    int paddedSize = 0;
+    return read_table<VifMeshSub1>(data, size, sub0.sub1_data, sub0.sub1_count, "VIM", name, "sub1 entries");
+}
 
-    const char *ptr = &buffer[0x20];
-    char c = *ptr++;
+Table<VifMeshSub2> Mesh::sub2(const VifMeshSub0 &sub0) const
+{
+    return read_table<VifMeshSub2>(data, size, sub0.sub2_data, sub0.sub2_count, "VIM", name, "sub2 entries");
+}
 
-    while (c != 0x0) {
-        c = *ptr++;
-        filenameSize++;
+Mesh read(const unsigned char *data, std::uint64_t size, const std::string &name)
+{
+    if (size < kNamesOffset) {
+        throw ValidationError(fmt::format("VIM '{}': Smaller than its header", name));
     }
-    filenameSize += 2;    // Add the null byte
-
-    paddedSize = filenameSize - 1;
 
-    while ((*ptr & 0xFF) == 0x0) {
-        ptr++;
-        paddedSize++;
+    Mesh mesh;
+    mesh.data = data;
+    mesh.size = size;
+    mesh.name = name;
+    mesh.version = read_u32(data, 0x0);
+    mesh.flags = read_u32(data, 0x4);
+    mesh.field_0x8 = read_u32(data, 0x8);
+    mesh.field_0xc = read_u32(data, 0xC);
+    mesh.field_0x10 = read_u32(data, 0x10);
+    mesh.field_0x14 = read_u32(data, 0x14);
+    mesh.field_0x18 = read_u32(data, 0x18);
+
+    if (mesh.version != kVersion) {
+        throw ValidationError(fmt::format("VIM '{}': Version 0x{:x}, expected 0x{:x}", name, mesh.version, kVersion));
     }
 
-    spdlog::debug("VIM: Filename trimmed size: {}", filenameSize);
-    spdlog::debug("VIM: Filename padded size: {}", paddedSize);
+    /* Walk the names once, checking that each one and its padding end inside
+     * the file, so TextureNames can walk them unchecked. */
+    const auto num_textures = read_u32(data, 0x1C);
+    std::uint64_t offset = kNamesOffset;
+    for (std::uint32_t i = 0; i < num_textures; i++) {
+        offset = skip(data, size, skip(data, size, offset, 0x00, false), 0x00, true);
+        if (offset >= size) {
+            throw ValidationError(fmt::format("VIM '{}': Texture name {} of {} runs past the end of the file", name, i + 1, num_textures));
+        }
+    }
+    mesh.texture_names = TextureNames(data, kNamesOffset, num_textures);
 
-    char **names = new char *[count];
-    int offset = 0x20;
-    for (int i = 0; i < count; i++) {
-        names[i] = new char[filenameSize];
-        memcpy(names[i], &buffer[offset], filenameSize);
-        spdlog::debug("VIM: Filename {} offset {:02x}: {}", i + 1, offset, names[i]);
-        offset += paddedSize;
+    /* The table header follows a run of 0xFF, then 4 bytes. */
+    offset = skip(data, size, skip(data, size, offset, 0xFF, false), 0xFF, true) + 4;
+    if (offset + kTableHeaderSize > size) {
+        throw ValidationError(fmt::format("VIM '{}': No table header after the texture names", name));
     }
 
-    totalSize = paddedSize * count;
+    mesh.sub0 = read_table<VifMeshSub0>(data, size, read_u32(data, offset + 4), read_u32(data, offset), "VIM", name, "sub0 entries");
+    mesh.bones = read_table<VifBone>(data, size, read_u32(data, offset + 12), read_u32(data, offset + 8), "VIM", name, "bones");
+    mesh.field_0x4c = read_u32(data, offset + 16);
+    mesh.sub4 = read_table<VifMeshSub4>(data, size, read_u32(data, offset + 24), read_u32(data, offset + 20), "VIM", name, "sub4 entries");
+    mesh.field_0x58 = read_u32(data, offset + 28);
+    mesh.sub5 = read_table<VifMeshSub5>(data, size, read_u32(data, offset + 36), read_u32(data, offset + 32), "VIM", name, "sub5 entries");
+    mesh.data_0x64 = read_u32(data, offset + 40);
+    mesh.num_0x68 = read_u32(data, offset + 44);
+
+    spdlog::debug("VIM: '{}': {} textures, {} sub0, {} bones, {} sub4, {} sub5", name, num_textures, mesh.sub0.size(), mesh.bones.size(), mesh.sub4.size(), mesh.sub5.size());
 
-    return names;
+    return mesh;
 }
+
+}    // namespace ace3x::vim
@@ -4,54 +4,139 @@
 #define ACE3X_FORMAT_READERS_VIM_HPP_
 
 #include <cstdint>
+#include <string>
+#include <string_view>
 
-class VifMesh {
+#include "format-readers/table.hpp"
+#include "formats/vim.hpp"
+
+namespace ace3x::vim {
+
+constexpr std::uint32_t kVersion {0xB};
+
+/* The texture names after the header, each padded with zeros up to the next.
+ * The padding is not assumed to be the same for every name. */
+class TextureNames {
 public:
-    ~VifMesh();
-
-    void read(const unsigned char *buffer);
-
-    //private:
-    std::uint32_t version_0x0_;
-    std::uint32_t flags_0x4_;
-    std::uint32_t field_0x8_;
-    std::uint32_t field_0xc_;
-    std::uint32_t field_0x10_;
-    std::uint32_t field_0x14_;
-    std::uint32_t field_0x18_;
-
-    std::uint32_t numTextures_0x1c_;
-    char **textureNames_0x20_ {nullptr};
-    std::uint32_t *rtTextureHandles_0x24_;    // 0x1a8
-
-    // --
-    std::uint32_t sub0_count_;    // 0x1c0
-    std::uint32_t sub0_data_;     // 0x1c4
-    // --
-
-    // --
-    std::uint32_t vifBone_count_;    // 0x1c8
-    std::uint32_t vifBone_data_;     // 0x1cc
-    // --
-
-    std::uint32_t field_0x4C_;    // 0x1d0
-
-    // --
-    std::uint32_t sub4_count_;    // 0x1d4
-    std::uint32_t sub4_data_;     // 0x1d8
-    // --
-
-    std::uint32_t field_0x58_;    // 0x1dc
-
-    // --
-    std::uint32_t sub5_count_;    // 0x1e0
-    std::uint32_t sub5_data_;     // 0x1e4
-    // --
-
-    // -- ?
-    std::uint32_t **data_0x64_;    // 0x1e8
-    std::uint32_t num_0x68_;       // 0x1ec
-    // --
+    class Iterator {
+    public:
+        Iterator(const unsigned char *data, std::uint32_t offset, std::uint32_t remaining)
+            : data_(data)
+            , offset_(offset)
+            , remaining_(remaining)
+        {
+        }
+
+        std::string_view operator*() const
+        {
+            return reinterpret_cast<const char *>(data_ + offset_);
+        }
+
+        Iterator &operator++()
+        {
+            offset_ = next_name(data_, offset_);
+            remaining_--;
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return remaining_ != other.remaining_;
+        }
+
+    private:
+        const unsigned char *data_;
+        std::uint32_t offset_;
+        std::uint32_t remaining_;
+    };
+
+    TextureNames() = default;
+
+    TextureNames(const unsigned char *data, std::uint32_t offset, std::uint32_t count)
+        : data_(data)
+        , offset_(offset)
+        , count_(count)
+    {
+    }
+
+    std::uint32_t size() const
+    {
+        return count_;
+    }
+
+    Iterator begin() const
+    {
+        return {data_, offset_, count_};
+    }
+
+    Iterator end() const
+    {
+        return {data_, 0, 0};
+    }
+
+    /* Skips a name and the zeros after it. read() has checked that this stays
+     * inside the file. */
+    static std::uint32_t next_name(const unsigned char *data, std::uint32_t offset)
+    {
+        while (data[offset] != 0) {
+            offset++;
+        }
+        while (data[offset] == 0) {
+            offset++;
+        }
+        return offset;
+    }
+
+private:
+    const unsigned char *data_ {nullptr};
+    std::uint32_t offset_ {0};
+    std::uint32_t count_ {0};
 };
 
+/* A parsed VIM. Everything points into the data and name it was read from,
+ * which must outlive it. */
+struct Mesh {
+    std::uint32_t version {0};
+    std::uint32_t flags {0};
+    std::uint32_t field_0x8 {0};
+    std::uint32_t field_0xc {0};
+    std::uint32_t field_0x10 {0};
+    std::uint32_t field_0x14 {0};
+    std::uint32_t field_0x18 {0};
+
+    TextureNames texture_names;
+
+    Table<VifMeshSub0> sub0;
+    Table<VifBone> bones;
+    std::uint32_t field_0x4c {0};
+    Table<VifMeshSub4> sub4;
+    std::uint32_t field_0x58 {0};
+    Table<VifMeshSub5> sub5;
+    std::uint32_t data_0x64 {0};
+    std::uint32_t num_0x68 {0};
+
+    /* The NUL-terminated string at offset, empty if it is outside the file. */
+    std::string_view string_at(std::uint32_t offset) const;
+
+    /* The tables a VifMeshSub0 points to. Throw ValidationError if they are
+     * out of bounds. */
+    Table<VifMeshSub1> sub1(const VifMeshSub0 &sub0) const;
+    Table<VifMeshSub2> sub2(const VifMeshSub0 &sub0) const;
+
+    const unsigned char *data {nullptr};
+    std::uint64_t size {0};
+    /* For messages, a view of the name read() was given. */
+    std::string_view name;
+};
+
+/* Reads the header, texture names and table locations without allocating.
+ * Every table is bounds checked here, so items can be read from it without
+ * further checks.
+ *
+ * Throws ValidationError if the version is not kVersion or anything is out of
+ * bounds. */
+Mesh read(const unsigned char *data, std::uint64_t size, const std::string &name);
+
+}    // namespace ace3x::vim
+
 #endif    // ACE3X_FORMAT_READERS_VIM_HPP_
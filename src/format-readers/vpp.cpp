@@ -3,23 +3,16 @@
 #include <spdlog/spdlog.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "format-readers/validation-error.hpp"
 
 namespace ace3x::vpp {
 
-std::uint32_t align_to_chunk(std::uint32_t addr)
+std::uint64_t align_to_chunk(std::uint64_t addr)
 {
-    if (addr == 0) {
-        return addr;
-    }
-
-    int left = addr % kChunkSize;
-
-    if (left > 0) {
-        return (addr + (kChunkSize - left));
-    }
-
-    return addr;
+    return (addr + kChunkSize - 1) / kChunkSize * kChunkSize;
 }
 
 std::vector<unsigned char> decompress(const unsigned char* const data, std::uint32_t compressedSize, std::uint32_t uncompressedSize)
@@ -92,7 +85,7 @@ std::vector<unsigned char> decompress(const unsigned char* const data, std::uint
         spdlog::debug("zlib message: {}", std::string(stream.msg));
     }
 
-    if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+    if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) {
         throw std::runtime_error("Decompression failed.");
     }
 
@@ -131,8 +124,9 @@ VppInfo read_info(const unsigned char* const data, const std::string& filename)
         throw ValidationError("signature mismatch");
     }
 
-    if ((info.header.fileCount <= 0) || (info.header.fileCount > 5000)) {
-        throw ValidationError("too many files " + std::to_string(info.header.fileCount));
+    /* The directory is checked against the file size in read_entries. */
+    if (info.header.fileCount == 0) {
+        throw ValidationError("no files");
     }
 
     if (info.header.version != 2) {
@@ -147,42 +141,63 @@ VppInfo read_info(const unsigned char* const data, const std::string& filename)
     return info;
 }
 
-std::vector<ArchiveEntry> read_entries(const VppInfo& info, std::size_t file_size)
+std::vector<std::string> read_filenames(const char* data, std::uint64_t size, std::uint32_t count)
+{
+    std::vector<std::string> filenames;
+    filenames.reserve(std::min<std::uint64_t>(count, size));    // each takes at least a byte
+
+    std::uint64_t offset = 0;
+    while (offset < size && filenames.size() < count) {
+        filenames.emplace_back(data + offset, strnlen(data + offset, size - offset));
+        offset += filenames.back().size() + 1;
+    }
+
+    return filenames;
+}
+
+std::vector<ArchiveEntry> read_entries(const VppInfo& info, std::uint64_t file_size)
 {
+    const std::uint64_t directory_size = static_cast<std::uint64_t>(info.header.fileCount) * sizeof(VppV2DirectoryEntry);
+
+    if (kChunkSize + directory_size > file_size) {
+        throw ValidationError(fmt::format("directory of {} files does not fit", info.header.fileCount));
+    }
+
+    if (info.filenames_offset + info.header.filenamesSize > file_size) {
+        throw ValidationError("filenames do not fit");
+    }
+
     /* Read file list */
     std::vector<VppV2DirectoryEntry> dir_entries(info.header.fileCount);
-    std::memcpy(
-        dir_entries.data(),
-        &info.data[ace3x::vpp::kChunkSize],
-        info.header.fileCount * sizeof(VppV2DirectoryEntry));
+    std::memcpy(dir_entries.data(), &info.data[kChunkSize], directory_size);
 
-    /* Read filenames */
-    const std::uint32_t filenamesStart = ace3x::vpp::align_to_chunk(ace3x::vpp::kChunkSize + info.header.directorySize);
-    std::vector<std::string> filenames;
-    {
-        std::ptrdiff_t offset = 0;
-        do {
-            filenames.push_back(std::string(reinterpret_cast<const char*>(&info.data[filenamesStart] + offset)));
-            offset += filenames.back().size() + 1;
-        } while (offset < info.header.filenamesSize);
+    const char* const filenames_data = reinterpret_cast<const char*>(&info.data[info.filenames_offset]);
+    const auto filenames = read_filenames(filenames_data, info.header.filenamesSize, info.header.fileCount);
+
+    if (filenames.size() < info.header.fileCount) {
+        throw ValidationError(fmt::format("{} filenames for {} files", filenames.size(), info.header.fileCount));
     }
 
-    auto offset = info.data_offset;
+    std::uint64_t offset = info.data_offset;
 
     std::vector<ArchiveEntry> entries;
+    entries.reserve(info.header.fileCount);
 
-    for (std::uint16_t i = 0; i < info.header.fileCount; i++) {
-        const std::string filename = filenames[i];
-        const int size = dir_entries[i].uncompressedSize;
-        const int final_offset = info.compressed ? dir_entries[i].offset + info.data_offset : offset;
+    for (std::uint32_t i = 0; i < info.header.fileCount; i++) {
+        const std::string& filename = filenames[i];
+        const std::uint64_t size = dir_entries[i].uncompressedSize;
+        const std::uint64_t final_offset = info.compressed ? dir_entries[i].offset + info.data_offset : offset;
+
+        /* Uncompressed entries follow each other, so advance even past skipped ones. */
+        offset = align_to_chunk(offset + size);
 
         if (size == 0) {
-            spdlog::warn("VPP: Skipping entry '{}/{}' because size is 0", filename, filename);
+            spdlog::warn("VPP: Skipping entry '{}/{}' because size is 0", info.filename, filename);
             continue;
         }
 
-        if (static_cast<uint64_t>(final_offset) + size >= file_size) {
-            spdlog::warn("VPP: Skipping entry '{}/{}' because [offset 0x{:04x} + size 0x{:04x} = 0x{:04x}] exceeds data size 0x{:04x}", info.filename, filename, offset, size, offset + size, file_size);
+        if (final_offset + size > file_size) {
+            spdlog::warn("VPP: Skipping entry '{}/{}' because [offset 0x{:04x} + size 0x{:04x} = 0x{:04x}] exceeds data size 0x{:04x}", info.filename, filename, final_offset, size, final_offset + size, file_size);
             continue;
         }
 
@@ -192,8 +207,6 @@ std::vector<ArchiveEntry> read_entries(const VppInfo& info, std::size_t file_siz
         entry.size = size;
         entry.offset = final_offset;
 
-        offset = align_to_chunk(offset + dir_entries[i].uncompressedSize);
-
         entries.push_back(entry);
     }
 
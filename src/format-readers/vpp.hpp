@@ -13,8 +13,8 @@
 namespace ace3x::vpp {
 
 struct VppInfo {
-    std::uint32_t filenames_offset {0};
-    std::uint32_t data_offset {0};
+    std::uint64_t filenames_offset {0};
+    std::uint64_t data_offset {0};
     const unsigned char* data {nullptr};
     VppV2Header header;
     bool compressed {false};
@@ -22,10 +22,14 @@ struct VppInfo {
 };
 
 inline constexpr std::uint16_t kChunkSize {0x800};
-std::uint32_t align_to_chunk(std::uint32_t addr);
+std::uint64_t align_to_chunk(std::uint64_t addr);
 std::vector<unsigned char> decompress(const unsigned char* const data, std::uint32_t compressedSize, std::uint32_t uncompressedSize);
 VppInfo read_info(const unsigned char* const data, const std::string& filename);
-std::vector<ArchiveEntry> read_entries(const VppInfo& info, std::size_t file_size);
+/* Up to count NUL separated names from the filenames block, stopping at its
+ * end even if the last one isn't terminated. */
+std::vector<std::string> read_filenames(const char* data, std::uint64_t size, std::uint32_t count);
+/* Throws ValidationError if the directory or filenames don't fit in file_size. */
+std::vector<ArchiveEntry> read_entries(const VppInfo& info, std::uint64_t file_size);
 
 }    // namespace ace3x::vpp
 
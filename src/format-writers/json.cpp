@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-writers/json.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <charconv>
+#include <cmath>
+
+namespace ace3x::json {
+
+std::string quoted(std::string_view str)
+{
+    std::string escaped {'"'};
+    for (const char c : str) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (byte < 0x20 || byte >= 0x7F) {
+            escaped += fmt::format("\\u{:04x}", byte);
+        }
+        else {
+            escaped += c;
+        }
+    }
+    escaped += '"';
+    return escaped;
+}
+
+std::string number(float value)
+{
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+
+    std::array<char, 32> digits;
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+    return std::string(digits.data(), result.ptr);
+}
+
+}    // namespace ace3x::json
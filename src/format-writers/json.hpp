@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_WRITERS_JSON_HPP_
+#define ACE3X_FORMAT_WRITERS_JSON_HPP_
+
+#include <string>
+#include <string_view>
+
+namespace ace3x::json {
+
+/* A JSON string literal. Game strings are not UTF-8, so bytes from 0x80 are
+ * read as Latin-1 and escaped like control characters. */
+std::string quoted(std::string_view str);
+
+/* The shortest text that reads back as the same float, or null if it is not
+ * finite. */
+std::string number(float value);
+
+}    // namespace ace3x::json
+
+#endif    // ACE3X_FORMAT_WRITERS_JSON_HPP_
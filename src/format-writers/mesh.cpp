@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-writers/mesh.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "format-writers/json.hpp"
+
+namespace ace3x::mesh {
+
+namespace {
+
+/* Text is collected here and written out whenever this much is pending. */
+constexpr std::size_t kFlushSize {1 << 20};
+
+class TextWriter {
+public:
+    explicit TextWriter(const std::string &path)
+        : path_(path)
+        , file_(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!file_.good()) {
+            throw std::runtime_error(fmt::format("Mesh: Failed to open '{}' for writing", path));
+        }
+        buffer_.reserve(kFlushSize + 256);
+    }
+
+    void append(std::string_view str)
+    {
+        buffer_.append(str);
+        flush_if_full();
+    }
+
+    void append(char c)
+    {
+        buffer_.push_back(c);
+    }
+
+    template <typename T>
+    void append_number(T value)
+    {
+        std::array<char, 32> digits;
+        const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+        buffer_.append(digits.data(), result.ptr);
+        flush_if_full();
+    }
+
+    void finish()
+    {
+        flush();
+        file_.close();
+        if (!file_) {
+            throw std::runtime_error(fmt::format("Mesh: Failed to write '{}'", path_));
+        }
+    }
+
+private:
+    void flush_if_full()
+    {
+        if (buffer_.size() >= kFlushSize) {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    std::string path_;
+    std::ofstream file_;
+    std::string buffer_;
+};
+
+template <typename T>
+void append_bytes(std::string &bin, const T *values, std::size_t count)
+{
+    bin.append(reinterpret_cast<const char *>(values), count * sizeof(T));
+}
+
+void pad_to_4(std::string &str, char padding)
+{
+    str.append((4 - str.size() % 4) % 4, padding);
+}
+
+}    // namespace
+
+void write_obj(const std::string &path, const p3d::Geometry &geometry)
+{
+    TextWriter out(path);
+
+    for (const auto &mesh : geometry.meshes) {
+        out.append("o ");
+        out.append(mesh.name);
+        out.append('\n');
+
+        for (std::uint32_t v = mesh.first_vertex; v < mesh.first_vertex + mesh.num_vertices; v++) {
+            out.append("v ");
+            out.append_number(geometry.positions[v * 3]);
+            out.append(' ');
+            out.append_number(geometry.positions[v * 3 + 1]);
+            out.append(' ');
+            out.append_number(geometry.positions[v * 3 + 2]);
+            out.append('\n');
+        }
+
+        /* OBJ indices count from 1 across the whole file, like Geometry's
+         * count from 0. */
+        for (std::uint32_t i = mesh.first_index; i + 2 < mesh.first_index + mesh.num_indices; i += 3) {
+            out.append("f ");
+            out.append_number(geometry.indices[i] + 1);
+            out.append(' ');
+            out.append_number(geometry.indices[i + 1] + 1);
+            out.append(' ');
+            out.append_number(geometry.indices[i + 2] + 1);
+            out.append('\n');
+        }
+
+        if (mesh.num_indices == 0) {
+            for (std::uint32_t v = mesh.first_vertex; v < mesh.first_vertex + mesh.num_vertices; v++) {
+                out.append("p ");
+                out.append_number(v + 1);
+                out.append('\n');
+            }
+        }
+    }
+
+    out.finish();
+}
+
+void write_glb(const std::string &path, const p3d::Geometry &geometry)
+{
+    std::string bin;
+    bin.reserve(geometry.positions.size() * sizeof(float) + geometry.indices.size() * sizeof(std::uint32_t));
+
+    std::string accessors;
+    std::string meshes;
+    std::string nodes;
+    std::string scene_nodes;
+    std::size_t num_accessors {0};
+    std::size_t num_meshes {0};
+
+    /* glTF indices are relative to their POSITION accessor, so each mesh gets
+     * its own rebased copy of its indices. */
+    std::string index_bin;
+    std::vector<std::uint32_t> rebased;
+
+    for (const auto &mesh : geometry.meshes) {
+        if (mesh.num_vertices == 0) {
+            continue;
+        }
+
+        const float *positions = &geometry.positions[mesh.first_vertex * 3];
+
+        std::array<float, 3> min;
+        std::array<float, 3> max;
+        min.fill(std::numeric_limits<float>::max());
+        max.fill(std::numeric_limits<float>::lowest());
+        for (std::uint32_t v = 0; v < mesh.num_vertices; v++) {
+            for (int c = 0; c < 3; c++) {
+                min[c] = std::min(min[c], positions[v * 3 + c]);
+                max[c] = std::max(max[c], positions[v * 3 + c]);
+            }
+        }
+
+        const auto position_offset = bin.size();
+        append_bytes(bin, positions, mesh.num_vertices * 3);
+
+        if (num_accessors) {
+            accessors += ',';
+        }
+        accessors += fmt::format(R"({{"bufferView":0,"byteOffset":{},"componentType":5126,"count":{},"type":"VEC3","min":[{},{},{}],"max":[{},{},{}]}})",
+                                 position_offset,
+                                 mesh.num_vertices,
+                                 json::number(min[0]),
+                                 json::number(min[1]),
+                                 json::number(min[2]),
+                                 json::number(max[0]),
+                                 json::number(max[1]),
+                                 json::number(max[2]));
+        const auto position_accessor = num_accessors++;
+
+        std::string primitive = fmt::format(R"({{"attributes":{{"POSITION":{}}})", position_accessor);
+
+        if (mesh.num_indices) {
+            rebased.assign(geometry.indices.begin() + mesh.first_index, geometry.indices.begin() + mesh.first_index + mesh.num_indices);
+            for (auto &index : rebased) {
+                index -= mesh.first_vertex;
+            }
+
+            accessors += fmt::format(R"(,{{"bufferView":1,"byteOffset":{},"componentType":5125,"count":{},"type":"SCALAR"}})", index_bin.size(), rebased.size());
+            append_bytes(index_bin, rebased.data(), rebased.size());
+            primitive += fmt::format(R"(,"indices":{},"mode":4}})", num_accessors++);
+        }
+        else {
+            primitive += R"(,"mode":0})";
+        }
+
+        if (num_meshes) {
+            meshes += ',';
+            nodes += ',';
+            scene_nodes += ',';
+        }
+        meshes += fmt::format(R"({{"name":{},"primitives":[{}]}})", json::quoted(mesh.name), primitive);
+        nodes += fmt::format(R"({{"name":{},"mesh":{}}})", json::quoted(mesh.name), num_meshes);
+        scene_nodes += std::to_string(num_meshes);
+        num_meshes++;
+    }
+
+    const auto positions_size = bin.size();
+    bin += index_bin;
+
+    std::string buffer_views = fmt::format(R"({{"buffer":0,"byteOffset":0,"byteLength":{},"target":34962}})", positions_size);
+    if (!index_bin.empty()) {
+        buffer_views += fmt::format(R"(,{{"buffer":0,"byteOffset":{},"byteLength":{},"target":34963}})", positions_size, index_bin.size());
+    }
+
+    /* Empty arrays and zero-length buffers are not allowed. */
+    std::string json = num_meshes ? fmt::format(R"({{"asset":{{"version":"2.0","generator":"Ace3x"}},"scene":0,"scenes":[{{"nodes":[{}]}}],"nodes":[{}],"meshes":[{}],"accessors":[{}],"bufferViews":[{}],"buffers":[{{"byteLength":{}}}]}})",
+                                                scene_nodes,
+                                                nodes,
+                                                meshes,
+                                                accessors,
+                                                buffer_views,
+                                                bin.size())
+                                  : std::string(R"({"asset":{"version":"2.0","generator":"Ace3x"}})");
+
+    pad_to_4(json, ' ');
+    pad_to_4(bin, '\0');
+
+    const std::uint32_t json_length = static_cast<std::uint32_t>(json.size());
+    const std::uint32_t bin_length = static_cast<std::uint32_t>(bin.size());
+    const std::uint32_t header[3] {0x46546C67, 2, 12 + 8 + json_length + (bin_length ? 8 + bin_length : 0)};
+    const std::uint32_t json_chunk[2] {json_length, 0x4E4F534A};
+    const std::uint32_t bin_chunk[2] {bin_length, 0x004E4942};
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.good()) {
+        throw std::runtime_error(fmt::format("Mesh: Failed to open '{}' for writing", path));
+    }
+
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(json_chunk), sizeof(json_chunk));
+    file.write(json.data(), json.size());
+    if (bin_length) {
+        file.write(reinterpret_cast<const char *>(bin_chunk), sizeof(bin_chunk));
+        file.write(bin.data(), bin.size());
+    }
+    file.close();
+
+    if (!file) {
+        throw std::runtime_error(fmt::format("Mesh: Failed to write '{}'", path));
+    }
+}
+
+void write(const std::string &path, const p3d::Geometry &geometry, MeshFormat format)
+{
+    switch (format) {
+        case MeshFormat::Obj:
+            write_obj(path, geometry);
+            break;
+        case MeshFormat::Glb:
+            write_glb(path, geometry);
+            break;
+    }
+}
+
+}    // namespace ace3x::mesh
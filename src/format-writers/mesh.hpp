@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_WRITERS_MESH_HPP_
+#define ACE3X_FORMAT_WRITERS_MESH_HPP_
+
+#include <string>
+
+#include "format-readers/p3d.hpp"
+
+namespace ace3x::mesh {
+
+enum class MeshFormat {
+    Obj,
+    Glb,
+};
+
+/* Wavefront OBJ, one object per mesh. Numbers are formatted with
+ * std::to_chars into a buffer that is written out in large blocks.
+ * Throws std::runtime_error if the file cannot be written. */
+void write_obj(const std::string &path, const p3d::Geometry &geometry);
+
+/* Binary glTF 2.0: one node and mesh per MeshRange, all sharing one buffer.
+ * Meshes without indices are written as points.
+ * Throws std::runtime_error if the file cannot be written. */
+void write_glb(const std::string &path, const p3d::Geometry &geometry);
+
+void write(const std::string &path, const p3d::Geometry &geometry, MeshFormat format);
+
+}    // namespace ace3x::mesh
+
+#endif    // ACE3X_FORMAT_WRITERS_MESH_HPP_
@@ -0,0 +1,523 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "format-writers/vpp.hpp"
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "format-readers/vpp.hpp"
+#include "formats/vpp.hpp"
+
+namespace {
+
+constexpr std::uint32_t kSignature {0x51890ACE};
+constexpr std::uint32_t kUncompressed {0xFFFFFFFF};
+constexpr std::size_t kWindowSize {32 * 1024};
+constexpr unsigned char kZeros[ace3x::vpp::kChunkSize] {};
+
+/* One piece of the data section, deflated on its own. */
+struct Block {
+    std::size_t entry {0};
+    const unsigned char* data {nullptr};
+    std::size_t size {0};
+    /* Up to kWindowSize bytes directly before `data`, from the same entry. */
+    std::size_t dictionary_size {0};
+    /* Zeros after the data, to reach the next chunk. */
+    std::size_t padding {0};
+    bool last {false};
+
+    std::vector<unsigned char> deflated;
+    uLong adler {0};
+};
+
+void deflate_into(z_stream& stream, std::vector<unsigned char>& out, const unsigned char* data, std::size_t size, int flush)
+{
+    stream.next_in = const_cast<unsigned char*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+
+    int ret = Z_OK;
+
+    do {
+        if (out.size() - stream.total_out < 64) {
+            out.resize(out.size() * 2 + 64);
+        }
+
+        stream.next_out = out.data() + stream.total_out;
+        stream.avail_out = static_cast<uInt>(out.size() - stream.total_out);
+
+        ret = deflate(&stream, flush);
+
+        if (ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("VPP writer: deflate failed");
+        }
+    } while (stream.avail_out == 0 || stream.avail_in > 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+void compress_block(Block& block, int level)
+{
+    z_stream stream {};
+
+    /* Raw deflate: the zlib header and trailer are written once for the whole stream. */
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("VPP writer: deflateInit2 failed");
+    }
+
+    if (block.dictionary_size) {
+        deflateSetDictionary(&stream, block.data - block.dictionary_size, static_cast<uInt>(block.dictionary_size));
+    }
+
+    block.deflated.resize(deflateBound(&stream, static_cast<uLong>(block.size + block.padding)) + 16);
+
+    /* A sync flush ends on a byte boundary with an empty stored block, so
+     * blocks can simply be concatenated. Only the last block finishes. */
+    const int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+
+    deflate_into(stream, block.deflated, block.data, block.size, block.padding ? Z_NO_FLUSH : flush);
+    if (block.padding) {
+        deflate_into(stream, block.deflated, kZeros, block.padding, flush);
+    }
+
+    block.deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    block.adler = adler32(adler32(0L, Z_NULL, 0), block.data, static_cast<uInt>(block.size));
+    block.adler = adler32(block.adler, kZeros, static_cast<uInt>(block.padding));
+}
+
+std::vector<Block> split_blocks(const std::vector<ace3x::vpp::WriterEntry>& entries, std::size_t block_size)
+{
+    std::vector<Block> blocks;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const auto& entry = entries[i];
+        const auto padding = ace3x::vpp::align_to_chunk(entry.size) - entry.size;
+
+        for (std::size_t offset = 0; offset < entry.size; offset += block_size) {
+            Block block;
+            block.entry = i;
+            block.data = entry.data + offset;
+            block.size = std::min(block_size, entry.size - offset);
+            block.dictionary_size = std::min(offset, kWindowSize);
+            block.padding = (offset + block.size == entry.size) ? padding : 0;
+            blocks.push_back(block);
+        }
+    }
+
+    /* The stream still needs its final block if every entry is empty. */
+    if (blocks.empty()) {
+        blocks.emplace_back();
+    }
+    blocks.back().last = true;
+
+    return blocks;
+}
+
+void write_padding(std::ostream& file, std::uint64_t& position)
+{
+    const auto aligned = ace3x::vpp::align_to_chunk(position);
+    file.write(reinterpret_cast<const char*>(kZeros), aligned - position);
+    position = aligned;
+}
+
+/* Header, directory and filenames of an uncompressed archive. */
+struct Layout {
+    VppV2Header header {};
+    std::vector<VppV2DirectoryEntry> directory;
+    std::string filenames;
+    std::uint64_t data_offset {0};
+};
+
+Layout build_layout(const std::string& path, const std::vector<ace3x::vpp::WriterEntry>& entries, const std::array<std::uint32_t, 4>& unknown)
+{
+    using ace3x::vpp::align_to_chunk;
+    using ace3x::vpp::kChunkSize;
+
+    if (entries.empty()) {
+        throw std::runtime_error("VPP writer: Cannot write an archive without entries");
+    }
+
+    /* Every size and offset in the header and directory is 32-bit. */
+    if (entries.size() > std::numeric_limits<std::uint32_t>::max() / sizeof(VppV2DirectoryEntry)) {
+        throw std::runtime_error(fmt::format("VPP writer: Too many entries ({})", entries.size()));
+    }
+
+    Layout layout;
+    layout.directory.resize(entries.size());
+
+    std::uint64_t data_size = 0;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        layout.filenames += entries[i].filename;
+        layout.filenames += '\0';
+
+        auto& dir = layout.directory[i];
+        dir.filenameEnd = static_cast<std::uint32_t>(layout.filenames.size());
+        dir.offset = static_cast<std::uint32_t>(data_size);
+        dir.nameHash = entries[i].name_hash;
+        dir.uncompressedSize = static_cast<std::uint32_t>(entries[i].size);
+        dir.compressedSize = dir.uncompressedSize;
+        dir.pkgPtr = 0;
+        dir.unk2 = 0;
+
+        if (entries[i].size > std::numeric_limits<std::uint32_t>::max() - kChunkSize || data_size + entries[i].size > std::numeric_limits<std::uint32_t>::max() - 2 * kChunkSize) {
+            throw std::runtime_error(fmt::format("VPP writer: '{}' does not fit in a 4 GiB archive", entries[i].filename));
+        }
+
+        data_size = align_to_chunk(data_size + entries[i].size);
+    }
+
+    if (layout.filenames.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("VPP writer: Filenames do not fit in a 4 GiB archive");
+    }
+
+    auto& header = layout.header;
+    header.signature = kSignature;
+    header.version = 2;
+    const auto name = std::filesystem::path(path).filename().string();
+    std::memcpy(header.name, name.data(), std::min(name.size(), sizeof(header.name) - 1));
+    header.unk0 = unknown[0];
+    header.unk1 = unknown[1];
+    header.fileCount = static_cast<std::uint32_t>(entries.size());
+    header.directorySize = static_cast<std::uint32_t>(layout.directory.size() * sizeof(VppV2DirectoryEntry));
+    header.filenamesSize = static_cast<std::uint32_t>(layout.filenames.size());
+    header.compressedDataSize = kUncompressed;
+    header.uncompressedDataSize = static_cast<std::uint32_t>(data_size);
+    header.unk2 = unknown[2];
+    header.unk3 = unknown[3];
+
+    const std::uint64_t filenames_offset = align_to_chunk(kChunkSize + header.directorySize);
+    layout.data_offset = align_to_chunk(filenames_offset + header.filenamesSize);
+
+    if (layout.data_offset + data_size > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("VPP writer: Archive does not fit in 4 GiB");
+    }
+
+    header.vppSize = static_cast<std::uint32_t>(layout.data_offset + data_size);
+
+    return layout;
+}
+
+/* Writes everything before the data section, leaving the stream at data_offset. */
+void write_sections(std::ostream& file, const Layout& layout)
+{
+    std::uint64_t position = 0;
+
+    file.write(reinterpret_cast<const char*>(&layout.header), sizeof(layout.header));
+    position += sizeof(layout.header);
+    write_padding(file, position);
+
+    file.write(reinterpret_cast<const char*>(layout.directory.data()), layout.header.directorySize);
+    position += layout.header.directorySize;
+    write_padding(file, position);
+
+    file.write(layout.filenames.data(), layout.filenames.size());
+    position += layout.filenames.size();
+    write_padding(file, position);
+}
+
+/* Replaces path with the finished temporary file, so the original is intact
+ * until the new archive is complete. */
+void replace_with(const std::string& temporary, const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error(fmt::format("VPP writer: Failed to replace '{}': {}", path, error.message()));
+    }
+}
+
+/* Copies size bytes at offset of in to out, a chunk at a time. */
+void copy_range(std::istream& in, std::uint64_t offset, std::uint64_t size, std::ostream& out, std::vector<char>& buffer)
+{
+    in.seekg(offset);
+    while (size > 0 && in.good()) {
+        const auto count = static_cast<std::streamsize>(std::min<std::uint64_t>(size, buffer.size()));
+        in.read(buffer.data(), count);
+        out.write(buffer.data(), in.gcount());
+        size -= static_cast<std::uint64_t>(in.gcount());
+    }
+}
+
+constexpr std::size_t kCopyBufferSize {1 << 20};
+
+}    // namespace
+
+namespace ace3x::vpp {
+
+void write(const std::string& path, const std::vector<WriterEntry>& entries, const WriteOptions& options)
+{
+    if (options.compress && (options.level < 0 || options.level > 9 || options.block_size == 0)) {
+        throw std::runtime_error(fmt::format("VPP writer: Bad compression level {} or block size {}", options.level, options.block_size));
+    }
+
+    auto layout = build_layout(path, entries, options.unknown);
+    auto& header = layout.header;
+    auto& directory = layout.directory;
+
+    std::vector<Block> blocks;
+    std::vector<unsigned char> stream_header;
+    std::vector<unsigned char> stream_trailer;
+
+    if (options.compress) {
+        blocks = split_blocks(entries, options.block_size);
+
+        const unsigned num_threads = options.thread_count ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<std::size_t> next_block {0};
+
+        auto worker = [&]() {
+            for (auto i = next_block++; i < blocks.size(); i = next_block++) {
+                compress_block(blocks[i], options.level);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto i = 0u; i < std::min<std::size_t>(num_threads, blocks.size()); i++) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        /* zlib header for deflate with a 32 KiB window, then the combined checksum, big endian. */
+        stream_header = {0x78, 0x9C};
+
+        uLong adler = adler32(0L, Z_NULL, 0);
+        std::uint64_t compressed_size = stream_header.size() + 4;
+
+        for (auto& dir : directory) {
+            dir.compressedSize = 0;
+        }
+
+        for (const auto& block : blocks) {
+            adler = adler32_combine(adler, block.adler, static_cast<z_off_t>(block.size + block.padding));
+            compressed_size += block.deflated.size();
+            directory[block.entry].compressedSize += static_cast<std::uint32_t>(block.deflated.size());
+        }
+
+        stream_trailer = {
+            static_cast<unsigned char>(adler >> 24),
+            static_cast<unsigned char>(adler >> 16),
+            static_cast<unsigned char>(adler >> 8),
+            static_cast<unsigned char>(adler),
+        };
+
+        if (compressed_size > std::numeric_limits<std::uint32_t>::max() - kChunkSize) {
+            throw std::runtime_error("VPP writer: Compressed data does not fit in a 4 GiB archive");
+        }
+
+        header.compressedDataSize = static_cast<std::uint32_t>(compressed_size);
+        header.vppSize = static_cast<std::uint32_t>(align_to_chunk(layout.data_offset + compressed_size));
+
+        spdlog::info("VPP writer: '{}': {} entries, {} -> {} bytes in {} blocks", path, entries.size(), header.uncompressedDataSize, compressed_size, blocks.size());
+    }
+
+    const auto temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.good()) {
+        throw std::runtime_error(fmt::format("VPP writer: Failed to open '{}' for writing", temporary));
+    }
+
+    write_sections(file, layout);
+
+    std::uint64_t position = layout.data_offset;
+
+    if (options.compress) {
+        file.write(reinterpret_cast<const char*>(stream_header.data()), stream_header.size());
+        for (const auto& block : blocks) {
+            file.write(reinterpret_cast<const char*>(block.deflated.data()), block.deflated.size());
+        }
+        file.write(reinterpret_cast<const char*>(stream_trailer.data()), stream_trailer.size());
+        position += header.compressedDataSize;
+        write_padding(file, position);
+    }
+    else {
+        for (const auto& entry : entries) {
+            file.write(reinterpret_cast<const char*>(entry.data), entry.size);
+            position += entry.size;
+            write_padding(file, position);
+        }
+    }
+
+    file.close();
+    if (!file) {
+        std::error_code error;
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error(fmt::format("VPP writer: Failed to write '{}'", temporary));
+    }
+
+    replace_with(temporary, path);
+}
+
+std::uint64_t patch(const std::string& path, const std::vector<WriterEntry>& changes)
+{
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.good()) {
+        throw std::runtime_error(fmt::format("VPP writer: Failed to open '{}'", path));
+    }
+
+    unsigned char header_data[sizeof(VppV2Header)];
+    file.read(reinterpret_cast<char*>(header_data), sizeof(header_data));
+    const auto info = read_info(header_data, std::filesystem::path(path).filename().string());
+
+    if (info.compressed) {
+        throw std::runtime_error(fmt::format("VPP writer: '{}' is compressed and cannot be patched, pack it again instead", path));
+    }
+
+    std::vector<VppV2DirectoryEntry> old_directory(info.header.fileCount);
+    file.seekg(kChunkSize);
+    file.read(reinterpret_cast<char*>(old_directory.data()), old_directory.size() * sizeof(VppV2DirectoryEntry));
+
+    std::string old_filenames(info.header.filenamesSize, '\0');
+    file.seekg(info.filenames_offset);
+    file.read(old_filenames.data(), old_filenames.size());
+
+    if (!file.good()) {
+        throw std::runtime_error(fmt::format("VPP writer: Failed to read the directory of '{}'", path));
+    }
+
+    /* The current contents, with data left null where the old bytes are kept. */
+    std::vector<WriterEntry> entries(info.header.fileCount);
+    std::vector<std::uint64_t> old_offsets(info.header.fileCount);
+    std::unordered_map<std::string, std::size_t> indices;
+
+    std::size_t name_start = 0;
+    std::uint64_t offset = info.data_offset;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const auto name_end = std::min(old_filenames.find('\0', name_start), old_filenames.size());
+        entries[i].filename = old_filenames.substr(name_start, name_end - name_start);
+        entries[i].size = old_directory[i].uncompressedSize;
+        entries[i].name_hash = old_directory[i].nameHash;
+        name_start = std::min(name_end + 1, old_filenames.size());
+
+        old_offsets[i] = offset;
+        offset = align_to_chunk(offset + entries[i].size);
+
+        auto key = entries[i].filename;
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        indices.emplace(std::move(key), i);
+    }
+
+    const auto old_count = entries.size();
+    std::vector<bool> changed(old_count);
+
+    for (const auto& change : changes) {
+        auto key = change.filename;
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+
+        if (const auto it = indices.find(key); it != indices.end()) {
+            auto& entry = entries[it->second];
+            entry.data = change.data;
+            entry.size = change.size;
+            if (it->second < old_count) {
+                changed[it->second] = true;
+            }
+        }
+        else {
+            indices.emplace(std::move(key), entries.size());
+            entries.push_back(change);
+        }
+    }
+
+    const std::array<std::uint32_t, 4> unknown {info.header.unk0, info.header.unk1, info.header.unk2, info.header.unk3};
+    const auto layout = build_layout(path, entries, unknown);
+
+    /* Entries before the first change in aligned size keep their slots. */
+    std::size_t first_moved = 0;
+    while (first_moved < old_count && align_to_chunk(entries[first_moved].size) == align_to_chunk(old_directory[first_moved].uncompressedSize)) {
+        first_moved++;
+    }
+
+    if (layout.data_offset != info.data_offset || first_moved < old_count) {
+        /* Entries move: build the new archive beside the old one, copying
+         * the kept entries across a chunk at a time, then swap it in. */
+        if (layout.data_offset != info.data_offset) {
+            spdlog::info("VPP writer: '{}': Directory no longer fits, rewriting the whole archive", path);
+        }
+
+        const auto temporary = path + ".tmp";
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.good()) {
+            throw std::runtime_error(fmt::format("VPP writer: Failed to open '{}' for writing", temporary));
+        }
+
+        write_sections(out, layout);
+
+        std::vector<char> buffer(kCopyBufferSize);
+        std::uint64_t position = layout.data_offset;
+
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            if (i < old_count && !changed[i]) {
+                copy_range(file, old_offsets[i], entries[i].size, out, buffer);
+            }
+            else {
+                out.write(reinterpret_cast<const char*>(entries[i].data), entries[i].size);
+            }
+            position += entries[i].size;
+            write_padding(out, position);
+        }
+
+        const bool read_ok = file.good();
+        file.close();
+        out.close();
+
+        if (!read_ok || !out) {
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            throw std::runtime_error(fmt::format("VPP writer: Failed to rebuild '{}'", path));
+        }
+
+        replace_with(temporary, path);
+
+        spdlog::info("VPP writer: '{}': Patched {} entries, rewrote all {} bytes", path, changes.size(), layout.header.vppSize);
+
+        return layout.header.vppSize;
+    }
+
+    /* Every old entry keeps its slot, so only changed entries, appended
+     * entries and the directory are written. */
+    std::uint64_t written = 0;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (i < old_count && !changed[i]) {
+            continue;
+        }
+
+        file.seekp(info.data_offset + layout.directory[i].offset);
+        file.write(reinterpret_cast<const char*>(entries[i].data), entries[i].size);
+        std::uint64_t position = info.data_offset + layout.directory[i].offset + entries[i].size;
+        write_padding(file, position);
+        written += align_to_chunk(entries[i].size);
+    }
+
+    file.seekp(0);
+    write_sections(file, layout);
+    written += layout.data_offset;
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error(fmt::format("VPP writer: Failed to write '{}'", path));
+    }
+
+    spdlog::info("VPP writer: '{}': Patched {} entries, wrote {} of {} bytes", path, changes.size(), written, layout.header.vppSize);
+
+    return written;
+}
+
+}    // namespace ace3x::vpp
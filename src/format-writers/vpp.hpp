@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMAT_WRITERS_VPP_HPP_
+#define ACE3X_FORMAT_WRITERS_VPP_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ace3x::vpp {
+
+struct WriterEntry {
+    std::string filename;
+    const unsigned char* data {nullptr};
+    std::size_t size {0};
+    /* Carried over when repacking. The hash function is unknown, so new files get 0. */
+    std::uint32_t name_hash {0};
+};
+
+struct WriteOptions {
+    bool compress {false};
+    int level {6};
+    /* 0 = one per hardware thread. */
+    unsigned thread_count {0};
+    /* Entries are split into blocks of this size to compress in parallel. */
+    std::size_t block_size {1 << 20};
+    /* unk0, unk1, unk2, unk3 of VppV2Header. Copy them from the source archive when repacking. */
+    std::array<std::uint32_t, 4> unknown {};
+};
+
+/* Writes a VPP v2 archive: header, directory and filenames each aligned to
+ * kChunkSize, then the entries, each padded to kChunkSize. The archive is
+ * written to path + ".tmp" and renamed over path once complete.
+ *
+ * When compressing, the data section becomes a single zlib stream. Blocks are
+ * deflated in parallel and joined with sync flushes, with each block primed
+ * with the 32 KiB before it in the same entry, and the Adler-32 of the whole
+ * stream is combined from the per-block checksums.
+ *
+ * Throws std::runtime_error if the archive cannot be written. */
+void write(const std::string& path, const std::vector<WriterEntry>& entries, const WriteOptions& options);
+
+/* Replaces entries of an uncompressed archive in place, matching names case
+ * insensitively, and appends entries that are not in it yet.
+ *
+ * Entries are found by adding up aligned sizes, so an entry can only be
+ * rewritten in its own slot if its aligned size is unchanged. If every old
+ * entry keeps its aligned size, and the directory and filenames still fit in
+ * their chunks, only the changed and appended entries and the directory are
+ * written, in place. Otherwise entries move, and the archive is rebuilt in
+ * path + ".tmp", copying kept entries from the old one in chunks, then
+ * renamed over it, so a failure never leaves a half-written archive.
+ *
+ * Returns the number of bytes written. Throws std::runtime_error on failure,
+ * and for compressed archives, which have to be rebuilt with write(). */
+std::uint64_t patch(const std::string& path, const std::vector<WriterEntry>& changes);
+
+}    // namespace ace3x::vpp
+
+#endif    // ACE3X_FORMAT_WRITERS_VPP_HPP_
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_FORMATS_LAYOUT_HPP_
+#define ACE3X_FORMATS_LAYOUT_HPP_
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+/* Describes the fields of the structs in this directory once, so tables of
+ * them can be read, checked and shown without code per struct:
+ *
+ *   namespace ace3x::layout {
+ *   template <>
+ *   struct Layout<P3DLayer> {
+ *       static constexpr auto fields = std::make_tuple(
+ *           field("layer_name", &P3DLayer::layer_name, Display::Hex),
+ *           field("num_objects", &P3DLayer::num_objects),
+ *           field("ptr_0xC", &P3DLayer::ptr_0xC, Display::Hex));
+ *   };
+ *   static_assert(covers<P3DLayer>());
+ *   }
+ *
+ * Fields are listed in file order. Array members become one column per
+ * element. The static_assert catches a field that was added to the struct but
+ * not to its layout, or padding the compiler put between fields. */
+
+namespace ace3x::layout {
+
+enum class Display {
+    Decimal,
+    Hex,
+    /* Floats, and 32-bit integers that hold a float's bits. */
+    Float,
+    /* Columns that are not fields, such as a name looked up elsewhere. */
+    Text,
+};
+
+template <typename T, typename M>
+struct Field {
+    using Struct = T;
+    using Member = M;
+    using Element = std::remove_all_extents_t<M>;
+
+    const char *name;
+    M T::*member;
+    Display display;
+
+    static constexpr std::size_t kExtent {std::is_array_v<M> ? std::extent_v<M> : 1};
+};
+
+template <typename M>
+constexpr Display default_display()
+{
+    return std::is_floating_point_v<std::remove_all_extents_t<M>> ? Display::Float : Display::Decimal;
+}
+
+template <typename T, typename M>
+constexpr Field<T, M> field(const char *name, M T::*member, Display display = default_display<M>())
+{
+    static_assert(std::rank_v<M> <= 1, "Only flat arrays can be described");
+    return {name, member, display};
+}
+
+/* Specialised next to each struct with a `fields` tuple. */
+template <typename T>
+struct Layout;
+
+template <typename T, typename F>
+constexpr void for_each_field(F &&f)
+{
+    std::apply([&](const auto &...fields) { (f(fields), ...); }, Layout<T>::fields);
+}
+
+/* Whether the fields add up to the whole struct. */
+template <typename T>
+constexpr bool covers()
+{
+    std::size_t size = 0;
+    for_each_field<T>([&](const auto &field) { size += sizeof(typename std::decay_t<decltype(field)>::Member); });
+    return std::is_trivially_copyable_v<T> && size == sizeof(T);
+}
+
+/* Columns, counting each array element. */
+template <typename T>
+constexpr std::size_t num_columns()
+{
+    std::size_t count = 0;
+    for_each_field<T>([&](const auto &field) { count += std::decay_t<decltype(field)>::kExtent; });
+    return count;
+}
+
+/* Offset of a field in its struct. Member pointers cannot give this at
+ * compile time, so it is measured on a value. */
+template <typename T, typename M>
+std::size_t offset_of(const Field<T, M> &field)
+{
+    const T probe {};
+    return static_cast<std::size_t>(reinterpret_cast<const unsigned char *>(&(probe.*field.member)) - reinterpret_cast<const unsigned char *>(&probe));
+}
+
+}    // namespace ace3x::layout
+
+#endif    // ACE3X_FORMATS_LAYOUT_HPP_
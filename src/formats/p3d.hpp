@@ -3,6 +3,7 @@
 #ifndef ACE3X_FORMATS_P3D_HPP_
 #define ACE3X_FORMATS_P3D_HPP_
 
+#include "formats/layout.hpp"
 #include "formats/types.hpp"
 
 /* File structure in order:
@@ -194,4 +195,32 @@ struct P3DSub3 {
     u32 ptr_0x20;
 };
 
+namespace ace3x::layout {
+
+template <>
+struct Layout<P3DNavpoint> {
+    static constexpr auto fields = std::make_tuple(
+        field("unk_0x0", &P3DNavpoint::unk_0x0, Display::Hex),
+        field("unk_0x4", &P3DNavpoint::unk_0x4),
+        field("unk_0x8", &P3DNavpoint::unk_0x8, Display::Hex),
+        field("unk_0x14", &P3DNavpoint::unk_0x14),
+        field("unk_0x18", &P3DNavpoint::unk_0x18, Display::Hex),
+        field("unk_0x24", &P3DNavpoint::unk_0x24),
+        field("x", &P3DNavpoint::x),
+        field("y", &P3DNavpoint::y),
+        field("z", &P3DNavpoint::z));
+};
+static_assert(covers<P3DNavpoint>());
+
+template <>
+struct Layout<P3DLayer> {
+    static constexpr auto fields = std::make_tuple(
+        field("Name offset", &P3DLayer::layer_name, Display::Hex),
+        field("# objects", &P3DLayer::num_objects),
+        field("Offset", &P3DLayer::ptr_0xC, Display::Hex));
+};
+static_assert(covers<P3DLayer>());
+
+}    // namespace ace3x::layout
+
 #endif    // ACE3X_FORMATS_P3D_HPP_
@@ -5,6 +5,8 @@
 
 #include <cstdint>
 
+#include "formats/layout.hpp"
+
 struct VifMeshSub5 {
     uint32_t data_0x0 {0};
     uint32_t padding[7] {0};
@@ -56,4 +58,77 @@ struct VifMeshSub0 {
     uint32_t sub2_data {0};    // VifMeshSub2
 };
 
+namespace ace3x::layout {
+
+template <>
+struct Layout<VifMeshSub5> {
+    static constexpr auto fields = std::make_tuple(
+        field("data_0x0", &VifMeshSub5::data_0x0, Display::Hex),
+        field("padding", &VifMeshSub5::padding, Display::Hex));
+};
+static_assert(covers<VifMeshSub5>());
+
+template <>
+struct Layout<VifMeshSub4> {
+    static constexpr auto fields = std::make_tuple(
+        field("data_0x0", &VifMeshSub4::data_0x0, Display::Hex),
+        field("padding", &VifMeshSub4::padding, Display::Float));
+};
+static_assert(covers<VifMeshSub4>());
+
+template <>
+struct Layout<VifBone> {
+    static constexpr auto fields = std::make_tuple(
+        field("Name offset", &VifBone::boneNameOff, Display::Hex),
+        field("x", &VifBone::x),
+        field("y", &VifBone::y),
+        field("z", &VifBone::z),
+        field("a", &VifBone::a),
+        field("b", &VifBone::b),
+        field("c", &VifBone::c),
+        field("padding", &VifBone::padding));
+};
+static_assert(covers<VifBone>());
+
+template <>
+struct Layout<VifMeshSub2> {
+    static constexpr auto fields = std::make_tuple(
+        field("Offset0", &VifMeshSub2::off0, Display::Hex),
+        field("field_0x4", &VifMeshSub2::field_0x4, Display::Hex),
+        field("field_0x6", &VifMeshSub2::field_0x6, Display::Hex));
+};
+static_assert(covers<VifMeshSub2>());
+
+template <>
+struct Layout<VifMeshSub1> {
+    static constexpr auto fields = std::make_tuple(
+        field("field_0x0", &VifMeshSub1::field_0x0),
+        field("field_0x2", &VifMeshSub1::field_0x2),
+        field("field_0x4", &VifMeshSub1::field_0x4),
+        field("field_0x6", &VifMeshSub1::field_0x6),
+        field("Mesh #", &VifMeshSub1::meshIdx),
+        field("Offset0", &VifMeshSub1::off0, Display::Hex),
+        field("Offset1", &VifMeshSub1::off1, Display::Hex),
+        field("field_0x14", &VifMeshSub1::field_0x14, Display::Hex),
+        field("Offset2", &VifMeshSub1::off2, Display::Hex),
+        field("Offset3", &VifMeshSub1::off3, Display::Hex),
+        field("Offset4", &VifMeshSub1::off4, Display::Hex),
+        field("Offset5", &VifMeshSub1::off5, Display::Hex),
+        field("Offset6", &VifMeshSub1::off6, Display::Hex));
+};
+static_assert(covers<VifMeshSub1>());
+
+template <>
+struct Layout<VifMeshSub0> {
+    static constexpr auto fields = std::make_tuple(
+        field("field_0x0", &VifMeshSub0::field_0x0),
+        field("Sub1 #", &VifMeshSub0::sub1_count),
+        field("Sub2 #", &VifMeshSub0::sub2_count),
+        field("Sub1 offset", &VifMeshSub0::sub1_data, Display::Hex),
+        field("Sub2 offset", &VifMeshSub0::sub2_data, Display::Hex));
+};
+static_assert(covers<VifMeshSub0>());
+
+}    // namespace ace3x::layout
+
 #endif    // ACE3X_FORMATS_VIM_HPP_
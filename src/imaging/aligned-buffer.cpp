@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "imaging/aligned-buffer.hpp"
+
+#include <new>
+
+namespace ace3x::imaging {
+
+template <typename T>
+T *AlignedBuffer<T>::reserve(std::size_t count)
+{
+    if (count > capacity_) {
+        data_.reset();
+        data_.reset(static_cast<T *>(::operator new[](count * sizeof(T), std::align_val_t(kAlignment))));
+        capacity_ = count;
+    }
+
+    return data_.get();
+}
+
+template <typename T>
+void AlignedBuffer<T>::Deleter::operator()(T *ptr) const
+{
+    ::operator delete[](ptr, std::align_val_t(kAlignment));
+}
+
+template class AlignedBuffer<std::uint32_t>;
+template class AlignedBuffer<float>;
+
+}    // namespace ace3x::imaging
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_IMAGING_ALIGNED_BUFFER_HPP_
+#define ACE3X_IMAGING_ALIGNED_BUFFER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ace3x::imaging {
+
+/* Cache line aligned storage that only reallocates when asked for more than
+ * it has ever held, so it can be reused frame after frame. Contents are not
+ * preserved across a reallocation. Instantiated for the types below only. */
+template <typename T>
+class AlignedBuffer {
+public:
+    static constexpr std::size_t kAlignment {64};
+
+    T *reserve(std::size_t count);
+
+    T *data()
+    {
+        return data_.get();
+    }
+
+    const T *data() const
+    {
+        return data_.get();
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    struct Deleter {
+        void operator()(T *ptr) const;
+    };
+
+    std::unique_ptr<T[], Deleter> data_;
+    std::size_t capacity_ {0};
+};
+
+/* Pixels, and depths loaded 4 at a time with aligned SSE loads. */
+using AlignedPixelBuffer = AlignedBuffer<std::uint32_t>;
+using AlignedDepthBuffer = AlignedBuffer<float>;
+
+extern template class AlignedBuffer<std::uint32_t>;
+extern template class AlignedBuffer<float>;
+
+}    // namespace ace3x::imaging
+
+#endif    // ACE3X_IMAGING_ALIGNED_BUFFER_HPP_
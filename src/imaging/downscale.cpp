@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "imaging/downscale.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ACE3X_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr std::uint32_t kLowChannels {0x00FF00FF};
+
+/* Rounded average of four ARGB pixels, two channels at a time in 16-bit lanes. */
+std::uint32_t average4(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d)
+{
+    const std::uint32_t lo = (a & kLowChannels) + (b & kLowChannels) + (c & kLowChannels) + (d & kLowChannels) + 0x00020002;
+    const std::uint32_t hi = ((a >> 8) & kLowChannels) + ((b >> 8) & kLowChannels) + ((c >> 8) & kLowChannels) + ((d >> 8) & kLowChannels) + 0x00020002;
+
+    return ((lo >> 2) & kLowChannels) | (((hi >> 2) & kLowChannels) << 8);
+}
+
+/* a + (b - a) * weight / 256 per channel, weight in [0, 256]. */
+std::uint32_t lerp(std::uint32_t a, std::uint32_t b, std::uint32_t weight)
+{
+    const std::uint32_t inverse = 256 - weight;
+    const std::uint32_t lo = ((a & kLowChannels) * inverse + (b & kLowChannels) * weight) >> 8;
+    const std::uint32_t hi = (((a >> 8) & kLowChannels) * inverse + ((b >> 8) & kLowChannels) * weight) >> 8;
+
+    return (lo & kLowChannels) | ((hi & kLowChannels) << 8);
+}
+
+}    // namespace
+
+namespace ace3x::imaging {
+
+void downscale_half(std::uint32_t *dst, const std::uint32_t *src, int width, int height)
+{
+    const int dst_width = (width + 1) / 2;
+    const int dst_height = (height + 1) / 2;
+
+    for (int y = 0; y < dst_height; y++) {
+        const std::uint32_t *row0 = src + static_cast<std::size_t>(2 * y) * width;
+        const std::uint32_t *row1 = (2 * y + 1 < height) ? row0 + width : row0;
+        std::uint32_t *out = dst + static_cast<std::size_t>(y) * dst_width;
+
+        int x = 0;
+
+#ifdef ACE3X_HAVE_SSE2
+        /* Two output pixels per iteration from four source columns. */
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(2);
+
+        for (; 2 * x + 4 <= width; x += 2) {
+            const __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x));
+            const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x));
+
+            /* Vertical sums, 16 bits per channel: [p0 p1] and [p2 p3]. */
+            const __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            const __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+            /* Horizontal sums: p0 + p1 and p2 + p3 in the low halves. */
+            const __m128i left_sum = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+            const __m128i right_sum = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+
+            __m128i sums = _mm_unpacklo_epi64(left_sum, right_sum);
+            sums = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(sums, zero));
+        }
+#endif
+
+        for (; x < dst_width; x++) {
+            const int x0 = 2 * x;
+            const int x1 = (x0 + 1 < width) ? x0 + 1 : x0;
+            out[x] = average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+        }
+    }
+}
+
+void resample_bilinear(std::uint32_t *dst, int dst_width, int dst_height, const std::uint32_t *src, int src_width, int src_height)
+{
+    /* Sample at pixel centres: src = (dst + 0.5) * scale - 0.5, in 16.16. */
+    const std::int64_t step_x = (static_cast<std::int64_t>(src_width) << 16) / dst_width;
+    const std::int64_t step_y = (static_cast<std::int64_t>(src_height) << 16) / dst_height;
+
+    std::vector<int> x0s(dst_width);
+    std::vector<int> x1s(dst_width);
+    std::vector<std::uint32_t> x_weights(dst_width);
+
+    for (int x = 0; x < dst_width; x++) {
+        const std::int64_t sx = std::max<std::int64_t>(0, x * step_x + step_x / 2 - 0x8000);
+        x0s[x] = std::min(static_cast<int>(sx >> 16), src_width - 1);
+        x1s[x] = std::min(x0s[x] + 1, src_width - 1);
+        x_weights[x] = static_cast<std::uint32_t>((sx >> 8) & 0xFF);
+    }
+
+    for (int y = 0; y < dst_height; y++) {
+        const std::int64_t sy = std::max<std::int64_t>(0, y * step_y + step_y / 2 - 0x8000);
+        const int y0 = std::min(static_cast<int>(sy >> 16), src_height - 1);
+        const int y1 = std::min(y0 + 1, src_height - 1);
+        const auto y_weight = static_cast<std::uint32_t>((sy >> 8) & 0xFF);
+
+        const std::uint32_t *row0 = src + static_cast<std::size_t>(y0) * src_width;
+        const std::uint32_t *row1 = src + static_cast<std::size_t>(y1) * src_width;
+        std::uint32_t *out = dst + static_cast<std::size_t>(y) * dst_width;
+
+        for (int x = 0; x < dst_width; x++) {
+            const auto top = lerp(row0[x0s[x]], row0[x1s[x]], x_weights[x]);
+            const auto bottom = lerp(row1[x0s[x]], row1[x1s[x]], x_weights[x]);
+            out[x] = lerp(top, bottom, y_weight);
+        }
+    }
+}
+
+std::vector<ScaledImage> build_mips(const std::uint32_t *src, int width, int height, int count)
+{
+    std::vector<ScaledImage> mips;
+
+    for (int level = 0; level < count && (width > 1 || height > 1); level++) {
+        ScaledImage mip;
+        mip.width = (width + 1) / 2;
+        mip.height = (height + 1) / 2;
+        mip.pixels.resize(static_cast<std::size_t>(mip.width) * mip.height);
+
+        downscale_half(mip.pixels.data(), src, width, height);
+
+        mips.push_back(std::move(mip));
+
+        src = mips.back().pixels.data();
+        width = mips.back().width;
+        height = mips.back().height;
+    }
+
+    return mips;
+}
+
+ScaledImage fit(const std::uint32_t *src, int width, int height, int max_size)
+{
+    ScaledImage result;
+
+    if (width <= max_size && height <= max_size) {
+        result.width = width;
+        result.height = height;
+        result.pixels.resize(static_cast<std::size_t>(width) * height);
+        std::memcpy(result.pixels.data(), src, result.pixels.size() * sizeof(std::uint32_t));
+        return result;
+    }
+
+    const int longest = std::max(width, height);
+    const int target_width = std::max(1, static_cast<int>(static_cast<std::int64_t>(width) * max_size / longest));
+    const int target_height = std::max(1, static_cast<int>(static_cast<std::int64_t>(height) * max_size / longest));
+
+    /* Box filter down to within 2x of the target, then one bilinear step. */
+    ScaledImage current;
+    const std::uint32_t *pixels = src;
+    int current_width = width;
+    int current_height = height;
+
+    while (current_width / 2 >= target_width && current_height / 2 >= target_height) {
+        ScaledImage half;
+        half.width = (current_width + 1) / 2;
+        half.height = (current_height + 1) / 2;
+        half.pixels.resize(static_cast<std::size_t>(half.width) * half.height);
+
+        downscale_half(half.pixels.data(), pixels, current_width, current_height);
+
+        current = std::move(half);
+        pixels = current.pixels.data();
+        current_width = current.width;
+        current_height = current.height;
+    }
+
+    if (current_width == target_width && current_height == target_height && pixels != src) {
+        return current;
+    }
+
+    result.width = target_width;
+    result.height = target_height;
+    result.pixels.resize(static_cast<std::size_t>(target_width) * target_height);
+    resample_bilinear(result.pixels.data(), target_width, target_height, pixels, current_width, current_height);
+
+    return result;
+}
+
+}    // namespace ace3x::imaging
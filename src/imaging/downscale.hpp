@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_IMAGING_DOWNSCALE_HPP_
+#define ACE3X_IMAGING_DOWNSCALE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "format-readers/peg.hpp"
+
+namespace ace3x::imaging {
+
+struct ScaledImage {
+    int width {0};
+    int height {0};
+    ace3x::peg::PixelBuffer pixels;
+};
+
+/* Halves an ARGB32 image with a rounded 2x2 box filter. Odd edges are clamped.
+ * dst must hold ((width + 1) / 2) * ((height + 1) / 2) pixels. */
+void downscale_half(std::uint32_t *dst, const std::uint32_t *src, int width, int height);
+
+/* Bilinear resample to an exact size, 16.16 fixed point. Meant for the last,
+ * less than 2x, step after downscale_half. */
+void resample_bilinear(std::uint32_t *dst, int dst_width, int dst_height, const std::uint32_t *src, int src_width, int src_height);
+
+/* Mip levels 1..count (level n is 1/2^n of the source). Stops early at 1x1. */
+std::vector<ScaledImage> build_mips(const std::uint32_t *src, int width, int height, int count);
+
+/* Fits the image inside max_size x max_size keeping the aspect ratio.
+ * Never upscales. */
+ScaledImage fit(const std::uint32_t *src, int width, int height, int max_size);
+
+}    // namespace ace3x::imaging
+
+#endif    // ACE3X_IMAGING_DOWNSCALE_HPP_
@@ -0,0 +1,487 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "imaging/rasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ACE3X_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "parallel.hpp"
+
+namespace {
+
+/* Vertices and triangles are handed out to threads in chunks this big. */
+constexpr std::size_t kChunkSize {4096};
+
+/* Normalised (0.3, 1, 0.5). */
+constexpr float kLight[3] {0.254f, 0.848f, 0.424f};
+
+std::uint32_t shade(std::uint32_t colour, float intensity)
+{
+    const auto scale = static_cast<std::uint32_t>(intensity * 256.0f);
+    const std::uint32_t rb = (((colour & 0x00FF00FF) * scale) >> 8) & 0x00FF00FF;
+    const std::uint32_t g = (((colour & 0x0000FF00) * scale) >> 8) & 0x0000FF00;
+    return 0xFF000000 | rb | g;
+}
+
+/* std::floor and std::ceil are library calls without SSE4.1. Screen
+ * coordinates are clamped first, so the conversion cannot overflow. */
+int floor_to_int(float value)
+{
+    value = std::clamp(value, -65536.0f, 65536.0f);
+    const int truncated = static_cast<int>(value);
+    return truncated - (value < static_cast<float>(truncated));
+}
+
+int ceil_to_int(float value)
+{
+    value = std::clamp(value, -65536.0f, 65536.0f);
+    const int truncated = static_cast<int>(value);
+    return truncated + (value > static_cast<float>(truncated));
+}
+
+std::array<float, 3> sub(const std::array<float, 3> &a, const std::array<float, 3> &b)
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+std::array<float, 3> cross(const std::array<float, 3> &a, const std::array<float, 3> &b)
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+std::array<float, 3> normalise(const std::array<float, 3> &v)
+{
+    const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length == 0.0f) {
+        return v;
+    }
+    return {v[0] / length, v[1] / length, v[2] / length};
+}
+
+}    // namespace
+
+namespace ace3x::imaging {
+
+Mat4 operator*(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 result;
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+            }
+            result.m[column * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near, float far)
+{
+    const float f = 1.0f / std::tan(fov_y / 2.0f);
+
+    Mat4 result;
+    result.m[0] = f / aspect;
+    result.m[5] = f;
+    result.m[10] = (far + near) / (near - far);
+    result.m[11] = -1.0f;
+    result.m[14] = 2.0f * far * near / (near - far);
+    return result;
+}
+
+Mat4 look_at(const std::array<float, 3> &eye, const std::array<float, 3> &target, const std::array<float, 3> &up)
+{
+    const auto forward = normalise(sub(target, eye));
+    const auto side = normalise(cross(forward, up));
+    const auto true_up = cross(side, forward);
+
+    Mat4 result;
+    for (int i = 0; i < 3; i++) {
+        result.m[i * 4 + 0] = side[i];
+        result.m[i * 4 + 1] = true_up[i];
+        result.m[i * 4 + 2] = -forward[i];
+    }
+    result.m[12] = -(side[0] * eye[0] + side[1] * eye[1] + side[2] * eye[2]);
+    result.m[13] = -(true_up[0] * eye[0] + true_up[1] * eye[1] + true_up[2] * eye[2]);
+    result.m[14] = forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2];
+    result.m[15] = 1.0f;
+    return result;
+}
+
+void Rasterizer::set_thread_count(unsigned count)
+{
+    thread_count_ = count;
+}
+
+void Rasterizer::resize(int width, int height)
+{
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    tiles_x_ = (width_ + kTileSize - 1) / kTileSize;
+    tiles_y_ = (height_ + kTileSize - 1) / kTileSize;
+    stride_ = tiles_x_ * kTileSize;
+    padded_height_ = tiles_y_ * kTileSize;
+
+    const auto num_pixels = static_cast<std::size_t>(stride_) * padded_height_;
+    colour_.reserve(num_pixels);
+    depth_.reserve(num_pixels);
+
+    point_bins_.resize(static_cast<std::size_t>(tiles_x_) * tiles_y_);
+}
+
+void Rasterizer::render(const std::vector<DrawBatch> &batches, const Mat4 &view_projection, std::uint32_t background)
+{
+    if (width_ == 0 || height_ == 0) {
+        return;
+    }
+
+    transform(batches, view_projection);
+    setup(batches);
+    bin_points(batches);
+
+    const unsigned num_threads = ace3x::resolve_thread_count(thread_count_);
+    const auto num_tiles = static_cast<std::size_t>(tiles_x_) * tiles_y_;
+
+    ace3x::parallel_for(num_threads, num_tiles, 1, [&](std::size_t begin, std::size_t end) {
+        for (auto tile = begin; tile < end; tile++) {
+            draw_tile(static_cast<int>(tile), background);
+        }
+    });
+}
+
+void Rasterizer::transform(const std::vector<DrawBatch> &batches, const Mat4 &view_projection)
+{
+    std::size_t num_vertices = 0;
+    for (const auto &batch : batches) {
+        num_vertices += batch.num_vertices;
+    }
+    vertices_.resize(num_vertices);
+
+    const unsigned num_threads = ace3x::resolve_thread_count(thread_count_);
+    const auto &m = view_projection.m;
+    const float half_width = width_ * 0.5f;
+    const float half_height = height_ * 0.5f;
+
+    std::size_t first = 0;
+    for (const auto &batch : batches) {
+        ScreenVertex *out = vertices_.data() + first;
+        const float *positions = batch.positions;
+
+        ace3x::parallel_for(num_threads, batch.num_vertices, kChunkSize, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; i++) {
+                const float x = positions[i * 3];
+                const float y = positions[i * 3 + 1];
+                const float z = positions[i * 3 + 2];
+
+                const float clip_x = m[0] * x + m[4] * y + m[8] * z + m[12];
+                const float clip_y = m[1] * x + m[5] * y + m[9] * z + m[13];
+                const float clip_z = m[2] * x + m[6] * y + m[10] * z + m[14];
+                const float clip_w = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+                auto &vertex = out[i];
+                vertex.visible = clip_w > 1e-6f && clip_z >= -clip_w && clip_z <= clip_w;
+                if (!vertex.visible) {
+                    continue;
+                }
+
+                const float inverse_w = 1.0f / clip_w;
+                vertex.x = (clip_x * inverse_w + 1.0f) * half_width;
+                vertex.y = (1.0f - clip_y * inverse_w) * half_height;
+                vertex.z = clip_z * inverse_w;
+            }
+        });
+
+        first += batch.num_vertices;
+    }
+}
+
+void Rasterizer::setup(const std::vector<DrawBatch> &batches)
+{
+    const auto num_tiles = static_cast<std::size_t>(tiles_x_) * tiles_y_;
+
+    std::size_t num_triangles = 0;
+    std::size_t num_chunks = 0;
+    for (const auto &batch : batches) {
+        num_triangles += batch.num_indices / 3;
+        num_chunks += (batch.num_indices / 3 + kChunkSize - 1) / kChunkSize;
+    }
+    triangles_.resize(num_triangles);
+
+    if (chunk_bins_.size() < num_chunks * num_tiles) {
+        chunk_bins_.resize(num_chunks * num_tiles);
+    }
+    for (std::size_t i = 0; i < num_chunks * num_tiles; i++) {
+        chunk_bins_[i].clear();
+    }
+    num_chunks_ = num_chunks;
+    chunk_triangle_counts_.assign(num_chunks, 0);
+
+    const unsigned num_threads = ace3x::resolve_thread_count(thread_count_);
+
+    std::size_t first_vertex = 0;
+    std::size_t first_triangle = 0;
+    std::size_t first_chunk = 0;
+    for (const auto &batch : batches) {
+        const ScreenVertex *vertices = vertices_.data() + first_vertex;
+        const auto batch_first_triangle = first_triangle;
+
+        ace3x::parallel_for(num_threads, batch.num_indices / 3, kChunkSize, [&](std::size_t begin, std::size_t end) {
+            const auto chunk = first_chunk + begin / kChunkSize;
+            auto *bins = &chunk_bins_[chunk * num_tiles];
+
+            for (auto i = begin; i < end; i++) {
+                const auto i0 = batch.indices[i * 3];
+                const auto i1 = batch.indices[i * 3 + 1];
+                const auto i2 = batch.indices[i * 3 + 2];
+                if (i0 >= batch.num_vertices || i1 >= batch.num_vertices || i2 >= batch.num_vertices) {
+                    continue;
+                }
+
+                const auto &v0 = vertices[i0];
+                auto v1 = vertices[i1];
+                auto v2 = vertices[i2];
+                if (!v0.visible || !v1.visible || !v2.visible) {
+                    continue;
+                }
+
+                float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+                if (std::abs(area) < 1e-8f) {
+                    continue;
+                }
+                if (area < 0.0f) {
+                    std::swap(v1, v2);
+                    area = -area;
+                }
+
+                auto &triangle = triangles_[batch_first_triangle + i];
+
+                /* The pixels whose centres are inside the bounding box. Most
+                 * triangles of a distant mesh cover none and stop here. */
+                triangle.min_x = std::max(0, ceil_to_int(std::min({v0.x, v1.x, v2.x}) - 0.5f));
+                triangle.min_y = std::max(0, ceil_to_int(std::min({v0.y, v1.y, v2.y}) - 0.5f));
+                triangle.max_x = std::min(width_ - 1, floor_to_int(std::max({v0.x, v1.x, v2.x}) - 0.5f));
+                triangle.max_y = std::min(height_ - 1, floor_to_int(std::max({v0.y, v1.y, v2.y}) - 0.5f));
+                if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+                    continue;
+                }
+
+                /* Edge k is opposite vertex k, so its value over the area is
+                 * that vertex's barycentric weight. */
+                const ScreenVertex *v[3] {&v0, &v1, &v2};
+                std::array<float, 3> c;
+                for (int k = 0; k < 3; k++) {
+                    const auto &p = *v[(k + 1) % 3];
+                    const auto &q = *v[(k + 2) % 3];
+                    const auto &origin = (p.x < q.x || (p.x == q.x && p.y < q.y)) ? p : q;
+                    triangle.a[k] = p.y - q.y;
+                    triangle.b[k] = q.x - p.x;
+                    triangle.origin_x[k] = origin.x;
+                    triangle.origin_y[k] = origin.y;
+                    c[k] = -(triangle.a[k] * origin.x + triangle.b[k] * origin.y);
+                }
+
+                const float inverse_area = 1.0f / area;
+                triangle.z_x = (triangle.a[0] * v0.z + triangle.a[1] * v1.z + triangle.a[2] * v2.z) * inverse_area;
+                triangle.z_y = (triangle.b[0] * v0.z + triangle.b[1] * v1.z + triangle.b[2] * v2.z) * inverse_area;
+                triangle.z_c = (c[0] * v0.z + c[1] * v1.z + c[2] * v2.z) * inverse_area;
+
+                /* |n . light| / |n|, one square root and no normalising. */
+                const float *p0 = batch.positions + i0 * 3;
+                const float *p1 = batch.positions + i1 * 3;
+                const float *p2 = batch.positions + i2 * 3;
+                const auto normal = cross({p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]}, {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]});
+                const float length_squared = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+                const float facing = std::abs(normal[0] * kLight[0] + normal[1] * kLight[1] + normal[2] * kLight[2]);
+                const float lambert = length_squared > 0.0f ? facing / std::sqrt(length_squared) : 0.0f;
+                triangle.colour = shade(batch.colour, 0.3f + 0.7f * lambert);
+
+                for (int ty = triangle.min_y / kTileSize; ty <= triangle.max_y / kTileSize; ty++) {
+                    for (int tx = triangle.min_x / kTileSize; tx <= triangle.max_x / kTileSize; tx++) {
+                        bins[ty * tiles_x_ + tx].push_back(static_cast<std::uint32_t>(batch_first_triangle + i));
+                    }
+                }
+                chunk_triangle_counts_[chunk]++;
+            }
+        });
+
+        first_vertex += batch.num_vertices;
+        first_triangle += batch.num_indices / 3;
+        first_chunk += (batch.num_indices / 3 + kChunkSize - 1) / kChunkSize;
+    }
+
+    num_drawn_triangles_ = 0;
+    for (const auto count : chunk_triangle_counts_) {
+        num_drawn_triangles_ += count;
+    }
+}
+
+void Rasterizer::bin_points(const std::vector<DrawBatch> &batches)
+{
+    points_.clear();
+    for (auto &bin : point_bins_) {
+        bin.clear();
+    }
+
+    std::size_t first_vertex = 0;
+    for (const auto &batch : batches) {
+        const ScreenVertex *vertices = vertices_.data() + first_vertex;
+        first_vertex += batch.num_vertices;
+
+        if (batch.indices) {
+            continue;
+        }
+
+        for (std::size_t i = 0; i < batch.num_vertices; i++) {
+            const auto &vertex = vertices[i];
+            if (!vertex.visible || vertex.x < -1.0f || vertex.y < -1.0f || vertex.x >= width_ + 1.0f || vertex.y >= height_ + 1.0f) {
+                continue;
+            }
+
+            const Point point {static_cast<int>(vertex.x), static_cast<int>(vertex.y), vertex.z, batch.colour | 0xFF000000};
+            const int min_tx = std::max(0, point.x - 1) / kTileSize;
+            const int min_ty = std::max(0, point.y - 1) / kTileSize;
+            const int max_tx = std::min(width_ - 1, point.x + 1) / kTileSize;
+            const int max_ty = std::min(height_ - 1, point.y + 1) / kTileSize;
+
+            for (int ty = min_ty; ty <= max_ty; ty++) {
+                for (int tx = min_tx; tx <= max_tx; tx++) {
+                    point_bins_[ty * tiles_x_ + tx].push_back(static_cast<std::uint32_t>(points_.size()));
+                }
+            }
+            points_.push_back(point);
+        }
+    }
+}
+
+void Rasterizer::draw_tile(int tile, std::uint32_t background)
+{
+    const int tile_x = (tile % tiles_x_) * kTileSize;
+    const int tile_y = (tile / tiles_x_) * kTileSize;
+
+    std::uint32_t *colour = colour_.data();
+    float *depth = depth_.data();
+
+    for (int y = tile_y; y < tile_y + kTileSize; y++) {
+        const auto row = static_cast<std::size_t>(y) * stride_ + tile_x;
+        std::fill_n(colour + row, kTileSize, background | 0xFF000000);
+        std::fill_n(depth + row, kTileSize, 1.0f);
+    }
+
+    const auto num_tiles = static_cast<std::size_t>(tiles_x_) * tiles_y_;
+
+    for (std::size_t chunk = 0; chunk < num_chunks_; chunk++) {
+        for (const auto index : chunk_bins_[chunk * num_tiles + tile]) {
+            draw_triangle(triangles_[index], tile_x, tile_y);
+        }
+    }
+
+    for (const auto index : point_bins_[tile]) {
+        const auto &point = points_[index];
+
+        for (int y = std::max(point.y - 1, tile_y); y <= std::min(point.y + 1, tile_y + kTileSize - 1); y++) {
+            for (int x = std::max(point.x - 1, tile_x); x <= std::min(point.x + 1, tile_x + kTileSize - 1); x++) {
+                const auto pixel = static_cast<std::size_t>(y) * stride_ + x;
+                if (point.z <= depth[pixel]) {
+                    depth[pixel] = point.z;
+                    colour[pixel] = point.colour;
+                }
+            }
+        }
+    }
+}
+
+void Rasterizer::draw_triangle(const Triangle &triangle, int tile_x, int tile_y)
+{
+    std::uint32_t *colour = colour_.data();
+    float *depth = depth_.data();
+
+    /* Rows and columns of the triangle inside this tile. Columns start on a
+     * multiple of 4 so each group of pixels is aligned. */
+    const int x0 = std::max(triangle.min_x, tile_x) & ~3;
+    const int x1 = std::min(triangle.max_x, tile_x + kTileSize - 1);
+    const int y0 = std::max(triangle.min_y, tile_y);
+    const int y1 = std::min(triangle.max_y, tile_y + kTileSize - 1);
+
+#ifdef ACE3X_HAVE_SSE2
+    const __m128 steps = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 a0 = _mm_set1_ps(triangle.a[0]);
+    const __m128 a1 = _mm_set1_ps(triangle.a[1]);
+    const __m128 a2 = _mm_set1_ps(triangle.a[2]);
+    const __m128 origin_x0 = _mm_set1_ps(triangle.origin_x[0]);
+    const __m128 origin_x1 = _mm_set1_ps(triangle.origin_x[1]);
+    const __m128 origin_x2 = _mm_set1_ps(triangle.origin_x[2]);
+    const __m128 z_x = _mm_set1_ps(triangle.z_x);
+    const __m128i fill = _mm_set1_epi32(static_cast<int>(triangle.colour));
+
+    for (int y = y0; y <= y1; y++) {
+        /* Pixel centres. Every value is evaluated from scratch rather than
+         * stepped, so shared edges round the same way in both triangles. */
+        const float py = y + 0.5f;
+        const __m128 row0 = _mm_set1_ps(triangle.b[0] * (py - triangle.origin_y[0]));
+        const __m128 row1 = _mm_set1_ps(triangle.b[1] * (py - triangle.origin_y[1]));
+        const __m128 row2 = _mm_set1_ps(triangle.b[2] * (py - triangle.origin_y[2]));
+        const __m128 row_z = _mm_set1_ps(triangle.z_y * py + triangle.z_c);
+
+        const auto row = static_cast<std::size_t>(y) * stride_;
+
+        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0)), steps);
+
+        for (int x = x0; x <= x1; x += 4, px = _mm_add_ps(px, four)) {
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, _mm_sub_ps(px, origin_x0)), row0);
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, _mm_sub_ps(px, origin_x1)), row1);
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, _mm_sub_ps(px, origin_x2)), row2);
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+
+            if (!_mm_movemask_ps(inside)) {
+                continue;
+            }
+
+            float *depth_ptr = depth + row + x;
+            const __m128 z = _mm_add_ps(_mm_mul_ps(z_x, px), row_z);
+            const __m128 old_z = _mm_load_ps(depth_ptr);
+            const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, old_z));
+
+            if (!_mm_movemask_ps(pass)) {
+                continue;
+            }
+
+            _mm_store_ps(depth_ptr, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old_z)));
+
+            auto *colour_ptr = reinterpret_cast<__m128i *>(colour + row + x);
+            const __m128i mask = _mm_castps_si128(pass);
+            _mm_store_si128(colour_ptr, _mm_or_si128(_mm_and_si128(mask, fill), _mm_andnot_si128(mask, _mm_load_si128(colour_ptr))));
+        }
+    }
+#else
+    for (int y = y0; y <= y1; y++) {
+        const float py = y + 0.5f;
+        const auto row = static_cast<std::size_t>(y) * stride_;
+
+        for (int x = x0; x <= x1; x++) {
+            const float px = x + 0.5f;
+            const float e0 = triangle.a[0] * (px - triangle.origin_x[0]) + triangle.b[0] * (py - triangle.origin_y[0]);
+            const float e1 = triangle.a[1] * (px - triangle.origin_x[1]) + triangle.b[1] * (py - triangle.origin_y[1]);
+            const float e2 = triangle.a[2] * (px - triangle.origin_x[2]) + triangle.b[2] * (py - triangle.origin_y[2]);
+            if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) {
+                continue;
+            }
+
+            const float z = triangle.z_x * px + triangle.z_y * py + triangle.z_c;
+            if (z < depth[row + x]) {
+                depth[row + x] = z;
+                colour[row + x] = triangle.colour;
+            }
+        }
+    }
+#endif
+}
+
+}    // namespace ace3x::imaging
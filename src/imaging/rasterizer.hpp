@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_IMAGING_RASTERIZER_HPP_
+#define ACE3X_IMAGING_RASTERIZER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "imaging/aligned-buffer.hpp"
+
+namespace ace3x::imaging {
+
+/* Column-major, like OpenGL: m[column * 4 + row]. */
+struct Mat4 {
+    std::array<float, 16> m {};
+};
+
+Mat4 operator*(const Mat4 &a, const Mat4 &b);
+
+/* Right-handed, depth mapped to [-1, 1]. fov_y is in radians. */
+Mat4 perspective(float fov_y, float aspect, float near, float far);
+
+Mat4 look_at(const std::array<float, 3> &eye, const std::array<float, 3> &target, const std::array<float, 3> &up);
+
+/* Vertices and the triangles or points to draw with them, in one colour. */
+struct DrawBatch {
+    /* x, y, z per vertex. */
+    const float *positions {nullptr};
+    std::size_t num_vertices {0};
+    /* Triangles. Without indices every vertex is drawn as a point. */
+    const std::uint32_t *indices {nullptr};
+    std::size_t num_indices {0};
+    /* 0xAARRGGBB */
+    std::uint32_t colour {0xFFFFFFFF};
+};
+
+/* A CPU-only triangle rasterizer with a depth buffer.
+ *
+ * A frame is drawn in three passes, each split over the worker threads:
+ * vertices are transformed, triangles are set up and sorted into kTileSize
+ * square tiles, then each thread clears and fills whole tiles, so no two
+ * threads ever write the same pixel and no locks are needed. Inside a tile four pixels are tested
+ * against the edge functions and the depth buffer at once with SSE2.
+ *
+ * Triangles are flat shaded by their angle to a fixed light from above, from
+ * both sides, since winding is not known for every format. Triangles that
+ * cross the near plane are dropped rather than clipped. Points are drawn as
+ * 3x3 squares. */
+class Rasterizer {
+public:
+    static constexpr int kTileSize {64};
+
+    /* 0 = one per hardware thread. */
+    void set_thread_count(unsigned count);
+
+    /* Resizes the colour and depth buffers. Buffers only grow. */
+    void resize(int width, int height);
+
+    void render(const std::vector<DrawBatch> &batches, const Mat4 &view_projection, std::uint32_t background);
+
+    /* XRGB32, stride() pixels per row. */
+    const std::uint32_t *pixels() const
+    {
+        return colour_.data();
+    }
+
+    int width() const
+    {
+        return width_;
+    }
+
+    int height() const
+    {
+        return height_;
+    }
+
+    int stride() const
+    {
+        return stride_;
+    }
+
+    /* Triangles that reached the tiles in the last frame. */
+    std::size_t num_drawn_triangles() const
+    {
+        return num_drawn_triangles_;
+    }
+
+private:
+    struct ScreenVertex {
+        float x;
+        float y;
+        float z;
+        bool visible;
+    };
+
+    /* Edge functions E(x, y) = a * (x - origin_x) + b * (y - origin_y),
+     * positive inside, and the depth plane z = z_x * x + z_y * y + z_c, in
+     * pixel coordinates. An edge's origin is the same endpoint in both of its
+     * triangles, so they compute exactly opposite values and leave no cracks. */
+    struct Triangle {
+        std::array<float, 3> a;
+        std::array<float, 3> b;
+        std::array<float, 3> origin_x;
+        std::array<float, 3> origin_y;
+        float z_x;
+        float z_y;
+        float z_c;
+        int min_x;
+        int min_y;
+        int max_x;
+        int max_y;
+        std::uint32_t colour;
+    };
+
+    struct Point {
+        int x;
+        int y;
+        float z;
+        std::uint32_t colour;
+    };
+
+private:
+    void transform(const std::vector<DrawBatch> &batches, const Mat4 &view_projection);
+    void setup(const std::vector<DrawBatch> &batches);
+    void bin_points(const std::vector<DrawBatch> &batches);
+    void draw_tile(int tile, std::uint32_t background);
+    void draw_triangle(const Triangle &triangle, int tile_x, int tile_y);
+
+private:
+    unsigned thread_count_ {0};
+
+    int width_ {0};
+    int height_ {0};
+    /* Both rounded up to whole tiles so tiles never need bounds checks. */
+    int stride_ {0};
+    int padded_height_ {0};
+    int tiles_x_ {0};
+    int tiles_y_ {0};
+
+    AlignedPixelBuffer colour_;
+    AlignedDepthBuffer depth_;
+
+    std::vector<ScreenVertex> vertices_;
+    std::vector<Triangle> triangles_;
+    std::vector<Point> points_;
+    /* Triangle indices per chunk of kChunkSize triangles and tile, at
+     * [chunk * tiles + tile], so threads can bin their own chunks and tiles
+     * still draw in order. */
+    std::vector<std::vector<std::uint32_t>> chunk_bins_;
+    std::vector<std::size_t> chunk_triangle_counts_;
+    std::size_t num_chunks_ {0};
+    /* Point indices per tile. */
+    std::vector<std::vector<std::uint32_t>> point_bins_;
+
+    std::size_t num_drawn_triangles_ {0};
+};
+
+}    // namespace ace3x::imaging
+
+#endif    // ACE3X_IMAGING_RASTERIZER_HPP_
@@ -8,13 +8,22 @@
 #include <QCommandLineOption>
 #include <QCommandLineParser>
 #include <QMessageBox>
+#include <QTimer>
 
+#include "batch/batch-main.hpp"
 #include "qt-sink.hpp"
+#include "startup-trace.hpp"
 #include "widgets/main-window.hpp"
 
 int main(int argc, char *argv[])
 {
+    if (ace3x::batch::is_batch_command(argc, argv)) {
+        return ace3x::batch::batch_main(argc, argv);
+    }
+
     QApplication app(argc, argv);
+    ace3x::startup::mark("QApplication");
+
     QCoreApplication::setApplicationName("Ace3X");
     QCoreApplication::setApplicationVersion("0.1");
     QCommandLineParser parser;
@@ -23,12 +32,17 @@ int main(int argc, char *argv[])
     QCommandLineOption fileOption(
         QStringList() << "f"
                       << "file",
-        "File to open",
+        "Archive, or directory of archives, to open instead of restoring the last session. Can be repeated.",
         "filename");
     parser.addOption(fileOption);
+    QCommandLineOption traceStartupOption("trace-startup", "Log the time spent in each phase of startup");
+    parser.addOption(traceStartupOption);
     parser.process(app);
 
+    ace3x::startup::set_enabled(parser.isSet(traceStartupOption));
+
     QApplication::setWindowIcon(QPixmap(":/images/ace3x_icon.png"));
+    ace3x::startup::mark("Command line and icon");
 
     /*
         MainWindow uses spdlog before the logging is fully initialised because
@@ -50,17 +64,31 @@ int main(int argc, char *argv[])
     spdlog::set_default_logger(logger);
 
     spdlog::cfg::load_env_levels();
+    ace3x::startup::mark("Logging");
 
     try {
-        if (parser.isSet(fileOption))
-            main_window.load(parser.value(fileOption));
+        if (parser.isSet(fileOption)) {
+            main_window.load(parser.values(fileOption));
+            ace3x::startup::mark("Loading archives");
+        }
+        else {
+            main_window.restore_session();
+            ace3x::startup::mark("Restoring session");
+        }
         main_window.show();
+        ace3x::startup::mark("Show");
     }
     catch (const std::exception &e) {
         fprintf(stderr, "%s\n", e.what());
         return EXIT_FAILURE;
     }
 
+    /* Runs once the first events, including the first paint, are handled. */
+    QTimer::singleShot(0, []() {
+        ace3x::startup::mark("First event loop pass");
+        ace3x::startup::report();
+    });
+
     try {
         app.exec();
     }
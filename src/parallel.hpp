@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_PARALLEL_HPP_
+#define ACE3X_PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ace3x {
+
+/* The threads to use for a thread count option, where 0 means one per
+ * hardware thread. */
+inline unsigned resolve_thread_count(unsigned thread_count)
+{
+    return thread_count ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/* Runs f(begin, end) over [0, count) in chunks of chunk_size, handed out in
+ * order to up to num_threads threads as each finishes its last chunk. The
+ * calling thread is one of them. */
+template <typename F>
+void parallel_for(unsigned num_threads, std::size_t count, std::size_t chunk_size, F &&f)
+{
+    const auto num_chunks = (count + chunk_size - 1) / chunk_size;
+
+    std::atomic<std::size_t> next_chunk {0};
+
+    auto worker = [&]() {
+        for (auto chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+            f(chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size));
+        }
+    };
+
+    const auto num_workers = static_cast<unsigned>(std::min<std::size_t>(num_threads, num_chunks));
+    if (num_workers <= 1) {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (auto i = 1u; i < num_workers; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+}    // namespace ace3x
+
+#endif    // ACE3X_PARALLEL_HPP_
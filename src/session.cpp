@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "session.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <string_view>
+
+namespace ace3x {
+
+namespace {
+
+constexpr std::string_view kLastOpenPath {"last_open_path"};
+constexpr std::string_view kArchive {"archive"};
+constexpr std::string_view kExpanded {"expanded"};
+constexpr std::string_view kSelected {"selected"};
+
+}    // namespace
+
+Session read_session(const std::filesystem::path &path)
+{
+    Session session;
+
+    std::ifstream file(path);
+    if (!file.good()) {
+        return session;
+    }
+
+    std::string line;
+    bool first_line = true;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        const auto space = line.find(' ');
+        const auto key = std::string_view(line).substr(0, space);
+        const auto value = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+        if (key == kLastOpenPath) {
+            session.last_open_path = value;
+        }
+        else if (key == kArchive) {
+            session.archives.push_back(value);
+        }
+        else if (key == kExpanded) {
+            session.expanded.push_back(value);
+        }
+        else if (key == kSelected) {
+            session.selected = value;
+        }
+        else if (first_line) {
+            session.last_open_path = line;
+        }
+        else if (!line.empty()) {
+            spdlog::warn("Session: Ignoring line '{}' of '{}'", line, path.string());
+        }
+
+        first_line = false;
+    }
+
+    return session;
+}
+
+bool write_session(const std::filesystem::path &path, const Session &session)
+{
+    auto temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.good()) {
+            spdlog::error("Session: Failed to open '{}' for writing", temporary.string());
+            return false;
+        }
+
+        file << kLastOpenPath << ' ' << session.last_open_path << '\n';
+        for (const auto &archive : session.archives) {
+            file << kArchive << ' ' << archive << '\n';
+        }
+        for (const auto &expanded : session.expanded) {
+            file << kExpanded << ' ' << expanded << '\n';
+        }
+        if (!session.selected.empty()) {
+            file << kSelected << ' ' << session.selected << '\n';
+        }
+
+        if (!file.flush()) {
+            spdlog::error("Session: Failed to write '{}'", temporary.string());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        spdlog::error("Session: Failed to replace '{}': {}", path.string(), error.message());
+        return false;
+    }
+
+    return true;
+}
+
+}    // namespace ace3x
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_SESSION_HPP_
+#define ACE3X_SESSION_HPP_
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ace3x {
+
+/* What the main window saves on exit and restores on the next start. */
+struct Session {
+    std::string last_open_path;
+    /* Absolute paths of the top-level archives, in tree order. */
+    std::vector<std::string> archives;
+    /* Absolute VFS paths of the expanded tree nodes, parents first. */
+    std::vector<std::string> expanded;
+    std::string selected;
+};
+
+/* One "key value" line per item. A file from before sessions, which only
+ * holds the last open path, is read as that. A missing file gives an empty
+ * session. */
+Session read_session(const std::filesystem::path &path);
+
+/* Writes to a temporary file renamed over path, so a crash never leaves half
+ * a session. */
+bool write_session(const std::filesystem::path &path, const Session &session);
+
+}    // namespace ace3x
+
+#endif    // ACE3X_SESSION_HPP_
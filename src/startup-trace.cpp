@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "startup-trace.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <vector>
+
+namespace ace3x::startup {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Phase {
+    const char *name;
+    Clock::time_point end;
+};
+
+const Clock::time_point process_start {Clock::now()};
+std::vector<Phase> phases;
+bool tracing {false};
+bool reported {false};
+
+double ms_between(Clock::time_point begin, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+}    // namespace
+
+void set_enabled(bool enabled)
+{
+    tracing = enabled;
+}
+
+bool enabled()
+{
+    return tracing;
+}
+
+void mark(const char *phase)
+{
+    if (!reported) {
+        phases.push_back({phase, Clock::now()});
+    }
+}
+
+void report()
+{
+    if (reported) {
+        return;
+    }
+    reported = true;
+
+    if (!tracing || phases.empty()) {
+        return;
+    }
+
+    auto begin = process_start;
+    for (const auto &phase : phases) {
+        spdlog::info("Startup: {:8.1f} ms  {}", ms_between(begin, phase.end), phase.name);
+        begin = phase.end;
+    }
+    spdlog::info("Startup: {:8.1f} ms  Total", ms_between(process_start, phases.back().end));
+
+    phases.clear();
+    phases.shrink_to_fit();
+}
+
+}    // namespace ace3x::startup
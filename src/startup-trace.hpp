@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_STARTUP_TRACE_HPP_
+#define ACE3X_STARTUP_TRACE_HPP_
+
+/* Times the phases of starting the GUI, for --trace-startup.
+ *
+ * Phases are marked as they end, whether or not tracing is enabled, since
+ * whether it is only becomes known once the command line is parsed. The first
+ * phase is timed from static initialisation. Only called from the GUI thread. */
+namespace ace3x::startup {
+
+void set_enabled(bool enabled);
+bool enabled();
+
+/* Records that phase has just finished. */
+void mark(const char *phase);
+
+/* If enabled, logs the time spent in each phase and in total. Phases marked
+ * after this are ignored. */
+void report();
+
+}    // namespace ace3x::startup
+
+#endif    // ACE3X_STARTUP_TRACE_HPP_
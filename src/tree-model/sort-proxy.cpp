@@ -20,7 +20,7 @@ bool TreeEntrySortProxy::lessThan(const QModelIndex &left, const QModelIndex &ri
 
     switch (left.column()) {
         case 0: {
-            return (QString::fromStdString(entryLeft->name).toLower() > QString::fromStdString(entryRight->name).toLower());
+            return entryLeft->sort_key > entryRight->sort_key;
         }
         case 1: {
             return (entryLeft->size < entryRight->size);
@@ -32,3 +32,35 @@ bool TreeEntrySortProxy::lessThan(const QModelIndex &left, const QModelIndex &ri
 
     return false;
 }
+
+void TreeEntrySortProxy::set_matches(const std::vector<VfsEntry *> &matches)
+{
+    visible_.clear();
+
+    for (const VfsEntry *entry : matches) {
+        /* Stop at the first ancestor already added, its own ancestors are too. */
+        for (const VfsEntry *e = entry; e && visible_.insert(e).second; e = e->parent) {
+        }
+    }
+
+    filtering_ = true;
+    invalidateFilter();
+}
+
+void TreeEntrySortProxy::clear_matches()
+{
+    visible_.clear();
+    filtering_ = false;
+    invalidateFilter();
+}
+
+bool TreeEntrySortProxy::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+    if (!filtering_) {
+        return true;
+    }
+
+    const auto index = sourceModel()->index(source_row, 0, source_parent);
+
+    return visible_.count(static_cast<const VfsEntry *>(index.internalPointer()));
+}
@@ -4,12 +4,28 @@
 #define ACE3X_TREE_MODEL_SORT_PROXY_HPP_
 
 #include <QSortFilterProxyModel>
+#include <unordered_set>
+#include <vector>
+
+struct VfsEntry;
 
 class TreeEntrySortProxy : public QSortFilterProxyModel {
 public:
     TreeEntrySortProxy(QObject *parent = nullptr);
 
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+    /* Shows only these entries and their ancestors. The matching is done
+     * up front by the VFS name index, so filtering a row is a set lookup. */
+    void set_matches(const std::vector<VfsEntry *> &matches);
+    void clear_matches();
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+
+private:
+    bool filtering_ {false};
+    std::unordered_set<const VfsEntry *> visible_;
 };
 
 #endif    // ACE3X_TREE_MODEL_SORT_PROXY_HPP_
@@ -5,9 +5,11 @@
 #include <spdlog/spdlog.h>
 
 #include <QLocale>
+#include <algorithm>
 #include <filesystem>
 #include <regex>
 
+#include "format-readers/registry.hpp"
 #include "vfs/vfs-entry.hpp"
 #include "vfs/vfs.hpp"
 
@@ -26,6 +28,23 @@ VfsEntry *TreeModel::itemFromIndex(const QModelIndex &index) const
     return static_cast<VfsEntry *>(index.internalPointer());
 }
 
+QModelIndex TreeModel::indexFromItem(VfsEntry *entry) const
+{
+    if (!entry) {
+        return QModelIndex();
+    }
+
+    if (!entry->parent) {
+        const auto it = std::find(invisible_root_.begin(), invisible_root_.end(), entry);
+        return it == invisible_root_.end() ? QModelIndex() : createIndex(static_cast<int>(it - invisible_root_.begin()), 0, entry);
+    }
+
+    const auto &siblings = entry->parent->entries;
+    const auto it = std::find(siblings.begin(), siblings.end(), entry);
+
+    return it == siblings.end() ? QModelIndex() : createIndex(static_cast<int>(it - siblings.begin()), 0, entry);
+}
+
 QModelIndex TreeModel::index(int row, int col, const QModelIndex &parent) const
 {
     if (!hasIndex(row, col, parent))
@@ -87,7 +106,12 @@ bool TreeModel::hasChildren(const QModelIndex &index) const
 
     auto *entry = itemFromIndex(index);
 
-    return entry->entries.size() || entry->extension == ".peg";
+    /* Offer to expand containers without listing them yet; rowCount does that. */
+    if (!entry->children_loaded) {
+        return ace3x::format_info(entry_format(entry)).children != nullptr;
+    }
+
+    return !entry->entries.empty();
 }
 
 QVariant TreeModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -111,11 +135,15 @@ int TreeModel::rowCount(const QModelIndex &parent) const
         return 0;
     }
 
-    const VfsEntry *parent_entry;
+    VfsEntry *parent_entry;
     if (!parent.isValid())
         return static_cast<int>(invisible_root_.size());
     else
-        parent_entry = static_cast<const VfsEntry *>(parent.internalPointer());
+        parent_entry = static_cast<VfsEntry *>(parent.internalPointer());
+
+    /* The view asks for the row count before any rows, so loading here needs
+     * no insert notifications. */
+    vfs_->load_children(parent_entry);
 
     return static_cast<int>(parent_entry->entries.size());
 }
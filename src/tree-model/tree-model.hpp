@@ -21,10 +21,16 @@ public:
     void addTopLevelEntry(VfsEntry *entry);
     void clear();
     VfsEntry *itemFromIndex(const QModelIndex &index) const;
+    QModelIndex indexFromItem(VfsEntry *entry) const;
 
     /* Returns the number of VPP's loaded */
     int load(const QString &path, Vfs *vfs);
 
+    const TreeRoot &top_level_entries() const
+    {
+        return invisible_root_;
+    }
+
 protected:
     QModelIndex parent(const QModelIndex &index) const;
     QVariant data(const QModelIndex &index, int role) const;
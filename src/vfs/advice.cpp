@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "vfs/advice.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if !defined(_WIN32)
+/* madvise wants a page aligned start. */
+std::pair<void *, std::size_t> page_range(const void *data, std::size_t size)
+{
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+
+    const auto begin = reinterpret_cast<std::uintptr_t>(data) & ~(page_size - 1);
+    const auto end = reinterpret_cast<std::uintptr_t>(data) + size;
+
+    return {reinterpret_cast<void *>(begin), end - begin};
+}
+
+void advise(const void *data, std::size_t size, int advice)
+{
+    if (!data || size == 0) {
+        return;
+    }
+
+    const auto [begin, length] = page_range(data, size);
+
+    if (const int error = posix_madvise(begin, length, advice); error != 0) {
+        spdlog::debug("VFS: posix_madvise({}) failed: {}", advice, std::strerror(error));
+    }
+}
+#endif
+
+}    // namespace
+
+void advise_access(const void *data, std::size_t size, AccessPattern pattern)
+{
+#if defined(_WIN32)
+    /* Mapped views have no access pattern hint on Windows. */
+    (void)data;
+    (void)size;
+    (void)pattern;
+#else
+    switch (pattern) {
+        case AccessPattern::Normal:
+            advise(data, size, POSIX_MADV_NORMAL);
+            break;
+        case AccessPattern::Sequential:
+            advise(data, size, POSIX_MADV_SEQUENTIAL);
+            break;
+        case AccessPattern::Random:
+            advise(data, size, POSIX_MADV_RANDOM);
+            break;
+    }
+#endif
+}
+
+void prefetch_range(const void *data, std::size_t size)
+{
+#if defined(_WIN32)
+    if (!data || size == 0) {
+        return;
+    }
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<void *>(data);
+    range.NumberOfBytes = size;
+
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0)) {
+        spdlog::debug("VFS: PrefetchVirtualMemory failed: {}", GetLastError());
+    }
+#else
+    advise(data, size, POSIX_MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_VFS_ADVICE_HPP_
+#define ACE3X_VFS_ADVICE_HPP_
+
+#include <cstddef>
+
+/* How mapped archive data is about to be read. */
+enum class AccessPattern {
+    Normal,
+    /* Front to back, e.g. exporting or hashing every entry: read ahead aggressively. */
+    Sequential,
+    /* Scattered entries, e.g. browsing in the GUI: don't read ahead. */
+    Random,
+};
+
+/* Passes the pattern to the kernel for the pages covering [data, data + size).
+ * A no-op where the platform has no such hint. */
+void advise_access(const void *data, std::size_t size, AccessPattern pattern);
+
+/* Asks the kernel to start reading [data, data + size) in the background,
+ * so a later access doesn't block on the disk. */
+void prefetch_range(const void *data, std::size_t size);
+
+#endif    // ACE3X_VFS_ADVICE_HPP_
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "vfs/container-indexer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <iterator>
+#include <utility>
+
+#include "format-readers/registry.hpp"
+#include "format-readers/validation-error.hpp"
+
+ContainerIndexer::~ContainerIndexer()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+        jobs_.clear();
+    }
+    wake_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ContainerIndexer::set_ready_callback(std::function<void()> callback)
+{
+    std::lock_guard lock(mutex_);
+    ready_ = std::move(callback);
+}
+
+void ContainerIndexer::enqueue(std::vector<Job> jobs)
+{
+    if (jobs.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        std::move(jobs.begin(), jobs.end(), std::back_inserter(jobs_));
+
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ContainerIndexer::run, this);
+        }
+    }
+    wake_.notify_one();
+}
+
+std::vector<ContainerIndexer::Result> ContainerIndexer::take_results()
+{
+    std::lock_guard lock(mutex_);
+    return std::exchange(results_, {});
+}
+
+bool ContainerIndexer::busy() const
+{
+    std::lock_guard lock(mutex_);
+    return !jobs_.empty() || running_job_ || !results_.empty();
+}
+
+void ContainerIndexer::cancel()
+{
+    std::unique_lock lock(mutex_);
+    jobs_.clear();
+    idle_.wait(lock, [this] {
+        return !running_job_;
+    });
+    results_.clear();
+}
+
+void ContainerIndexer::run()
+{
+    std::unique_lock lock(mutex_);
+
+    while (true) {
+        wake_.wait(lock, [this] {
+            return stop_ || !jobs_.empty();
+        });
+
+        if (stop_) {
+            return;
+        }
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        running_job_ = true;
+        lock.unlock();
+
+        Result result {job.container, ace3x::sniff_format(job.data, job.size, job.hint), {}};
+
+        if (const auto children = ace3x::format_info(result.format).children) {
+            try {
+                result.children = children(job.data, job.size, job.name);
+            }
+            catch (const ValidationError& e) {
+                spdlog::warn("VFS: Not indexing the entries of '{}': {}", job.name, e.what());
+            }
+        }
+
+        /* If cancel() is waiting, it takes the lock after this result is
+         * pushed and drops it along with the others. */
+        lock.lock();
+        running_job_ = false;
+        idle_.notify_all();
+
+        const bool was_empty = results_.empty();
+        results_.push_back(std::move(result));
+
+        if (was_empty && ready_) {
+            ready_();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_VFS_CONTAINER_INDEXER_HPP_
+#define ACE3X_VFS_CONTAINER_INDEXER_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "format-readers/archive-entry.hpp"
+#include "format-readers/format-id.hpp"
+
+struct VfsEntry;
+
+/* Lists the entries of containers such as PEGs on a worker thread, so names
+ * nested in them can be searched without reading every container header on
+ * the thread that owns the VFS. The worker only reads the container's bytes;
+ * the results are added to the VFS by its owner, see take_results(). */
+class ContainerIndexer {
+public:
+    struct Job {
+        /* Only handed back with the result, never dereferenced by the worker. */
+        VfsEntry* container;
+        const unsigned char* data;
+        std::uint64_t size;
+        std::string name;
+        ace3x::FormatId hint;
+    };
+
+    struct Result {
+        VfsEntry* container;
+        ace3x::FormatId format;
+        std::vector<ace3x::ArchiveEntry> children;
+    };
+
+    ~ContainerIndexer();
+
+    /* Called on the worker thread when results are waiting and none were
+     * before. Keep it short, the indexer is locked while it runs. */
+    void set_ready_callback(std::function<void()> callback);
+
+    void enqueue(std::vector<Job> jobs);
+    std::vector<Result> take_results();
+    /* Whether jobs are queued, running, or waiting to be taken. */
+    bool busy() const;
+
+    /* Drops queued jobs and results and waits for the running job, after
+     * which the data of every job may be unmapped. */
+    void cancel();
+
+private:
+    void run();
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<Job> jobs_;
+    std::vector<Result> results_;
+    std::function<void()> ready_;
+    bool running_job_ {false};
+    bool stop_ {false};
+    std::thread thread_;    // started by the first enqueue
+};
+
+#endif    // ACE3X_VFS_CONTAINER_INDEXER_HPP_
@@ -1,14 +1,78 @@
 #include "vfs/mmap-vfs.hpp"
 
 #include <spdlog/spdlog.h>
+#include <xxhash.h>
 
+#include <algorithm>
+#include <array>
 #include <filesystem>
+#include <fstream>
 
-#include "format-readers/peg.hpp"
+#include "format-readers/registry.hpp"
 #include "format-readers/validation-error.hpp"
 #include "format-readers/vpp.hpp"
+#include "formats/vpp.hpp"
 #include "vfs/vfs-entry.hpp"
 
+namespace {
+
+/* Lowercase extension including the dot, like std::filesystem::path::extension
+ * but without building a path for every entry. */
+std::string extension_of(const std::string& name)
+{
+    const auto dot = name.rfind('.');
+
+    if (dot == std::string::npos || dot == 0) {
+        return {};
+    }
+
+    std::string extension(name, dot);
+    for (auto& c : extension) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+
+    return extension;
+}
+
+std::string lowercase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return std::tolower(c);
+    });
+
+    return text;
+}
+
+/* The names in a VPP's filenames block, read without mapping the archive or
+ * decompressing it. Throws ValidationError if it isn't a VPP. */
+std::vector<std::string> archive_filenames(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    std::array<unsigned char, sizeof(VppV2Header)> header {};
+    if (!file.read(reinterpret_cast<char*>(header.data()), header.size())) {
+        throw ValidationError("too small for a header");
+    }
+
+    const auto info = ace3x::vpp::read_info(header.data(), path.filename().string());
+
+    if (info.filenames_offset + info.header.filenamesSize > std::filesystem::file_size(path)) {
+        throw ValidationError("filenames do not fit");
+    }
+
+    std::vector<char> filenames(info.header.filenamesSize);
+    file.seekg(static_cast<std::streamoff>(info.filenames_offset));
+    if (!file.read(filenames.data(), static_cast<std::streamsize>(filenames.size()))) {
+        throw ValidationError("filenames could not be read");
+    }
+
+    return ace3x::vpp::read_filenames(filenames.data(), filenames.size(), info.header.fileCount);
+}
+
+}    // namespace
+
 bool MmapVfs::add_root_archive(const std::string& path)
 {
     const auto& fs_path = std::filesystem::path(path);
@@ -49,7 +113,11 @@ bool MmapVfs::add_root_archive(const std::string& path)
     root_entry.absolute_path = absolute_path;
     root_entry.relative_path = path;
     root_entry.extension = ".vpp";
+    root_entry.format = ace3x::FormatId::Vpp;
+    root_entry.format_sniffed = true;    // read_info checks the signature
+    root_entry.children_loaded = true;
     root_entry.parent = nullptr;
+    root_entry.data = nullptr;
 
     if (!map_file(vpp.mmap, fs_path))
         return false;
@@ -57,60 +125,34 @@ bool MmapVfs::add_root_archive(const std::string& path)
     vpp.info = ace3x::vpp::read_info(reinterpret_cast<const unsigned char*>(vpp.mmap.data()), root_entry.name);
 
     if (vpp.info.compressed) {
-        if (!remap_as_decompressed_vpp(vpp.mmap, vpp.info)) {
+        /* Different versions of an archive with the same name must not share a decompressed copy. */
+        const auto version = fmt::format("{}:{}:{}", absolute_path, root_entry.size, std::filesystem::last_write_time(fs_path).time_since_epoch().count());
+        const auto cache_name = fmt::format("{}.{:016x}", root_entry.name, XXH3_64bits(version.data(), version.size()));
+
+        if (!remap_as_decompressed_vpp(vpp.mmap, vpp.info, cache_name)) {
             spdlog::error("VFS: failed to decompress file");
             return false;
         }
     }
 
+    advise_access(vpp.mmap.data(), vpp.mmap.mapped_length(), access_pattern_);
+
+    /* Read before anything is added, so an archive that throws here leaves
+     * no root entry behind for search and resolve to find. */
+    const auto archive_entries = ace3x::vpp::read_entries(vpp.info, vpp.mmap.mapped_length());
+
     vpp.entry = add_entry(root_entry);
     vpp.entry->root = vpp.entry;    // It is its own root
 
-    for (const auto& vpp_entry : ace3x::vpp::read_entries(vpp.info, vpp.mmap.mapped_length())) {
-        VfsEntry entry;
-        entry.index = vpp_entry.index;
-        entry.size = vpp_entry.size;
-        entry.offset_in_parent = vpp_entry.offset;
-        entry.offset_in_root = vpp_entry.offset;
-        entry.name = vpp_entry.filename;
-        entry.absolute_path = absolute_path + '/' + entry.name;
-        entry.relative_path = vpp.entry->relative_path + '/' + entry.name;
-        entry.parent = vpp.entry;
-        entry.root = vpp.entry;
-        entry.data = reinterpret_cast<const unsigned char*>(vpp.info.data) + entry.offset_in_parent;
-
-        entry.extension = std::filesystem::path(entry.name).extension().string();
-        std::transform(entry.extension.begin(), entry.extension.end(), entry.extension.begin(), [](unsigned char c) {
-            return std::tolower(c);
-        });
-
-        VfsEntry* entry_ = add_entry(entry);
-        vpp.entry->entries.push_back(entry_);
-
-        if (entry.extension == ".peg") {
-            for (const auto& peg_entry : ace3x::peg::read_entries(entry.data, entry.name)) {
-                VfsEntry image;
-                image.index = peg_entry.index;
-                image.size = peg_entry.size;
-                image.offset_in_parent = peg_entry.offset;
-                image.offset_in_root = entry_->offset_in_root + peg_entry.offset;
-                image.name = peg_entry.filename;
-                image.absolute_path = entry.absolute_path + '/' + peg_entry.filename;
-                image.relative_path = entry.relative_path + '/' + peg_entry.filename;
-                image.parent = entry_;
-                image.root = vpp.entry;
-                image.data = reinterpret_cast<const unsigned char*>(vpp.info.data) + image.offset_in_parent;
-
-                image.extension = std::filesystem::path(image.name).extension().string();
-                std::transform(image.extension.begin(), image.extension.end(), image.extension.begin(), [](unsigned char c) {
-                    return std::tolower(c);
-                });
-
-                entry_->entries.push_back(add_entry(image));
-            }
-        }
+    for (const auto& vpp_entry : archive_entries) {
+        vpp.entry->entries.push_back(add_child(vpp.entry, vpp.info.data, vpp_entry));
     }
 
+    /* PEGs and other containers are listed when first needed, or in the
+     * background. Reading every header here would touch a page of each one
+     * before anything is shown. */
+    index_in_background(vpp.entry->entries);
+
     loaded_vpps_[absolute_path] = std::move(vpp);
 
     return true;
@@ -129,9 +171,9 @@ bool MmapVfs::map_file(mio::mmap_source& mmap, const std::filesystem::path& path
     return true;
 }
 
-bool MmapVfs::remap_as_decompressed_vpp(mio::mmap_source& mmap, ace3x::vpp::VppInfo& info)
+bool MmapVfs::remap_as_decompressed_vpp(mio::mmap_source& mmap, ace3x::vpp::VppInfo& info, const std::string& cache_name)
 {
-    auto decomp_path {fmt::format("./temp/{}.decompressed", info.filename)};
+    auto decomp_path {fmt::format("./temp/{}.decompressed", cache_name)};
     decomp_path = std::filesystem::absolute(decomp_path).generic_string();
 
     if (!std::filesystem::exists(decomp_path)) {
@@ -183,22 +225,295 @@ VfsEntry* MmapVfs::add_entry(const VfsEntry& entry)
         return exists;
     }
 
-    return &entries_.emplace_back(entry);
+    VfsEntry* added = &entries_.emplace_back(entry);
+    entries_by_path_.emplace(added->absolute_path, added);
+
+    /* Fold once here so sorting and searching compare plain bytes. */
+    added->sort_key = added->name;
+    std::transform(added->sort_key.begin(), added->sort_key.end(), added->sort_key.begin(), [](unsigned char c) {
+        return std::tolower(c);
+    });
+
+    entries_by_name_.emplace(added->sort_key, added);
+    name_index_.add(added);
+
+    if (!missing_names_.empty()) {
+        missing_names_.clear();
+    }
+
+    return added;
 }
 
-VfsEntry* MmapVfs::get_entry(const std::string& absolute_path)
+VfsEntry* MmapVfs::add_child(VfsEntry* parent, const unsigned char* parent_data, const ace3x::ArchiveEntry& archive_entry)
 {
-    for (auto& entry : entries_) {
-        if (entry.absolute_path == absolute_path) {
-            return &entry;
+    VfsEntry entry;
+    entry.index = static_cast<int>(archive_entry.index);
+    entry.size = archive_entry.size;
+    entry.offset_in_parent = archive_entry.offset;
+    entry.offset_in_root = (parent == parent->root) ? archive_entry.offset : parent->offset_in_root + archive_entry.offset;
+    entry.name = archive_entry.filename;
+    entry.absolute_path = parent->absolute_path + '/' + entry.name;
+    entry.relative_path = parent->relative_path + '/' + entry.name;
+    entry.parent = parent;
+    entry.root = parent->root;
+    entry.data = parent_data + entry.offset_in_parent;
+
+    entry.extension = extension_of(entry.name);
+    entry.format = ace3x::format_from_extension(entry.extension);
+
+    return add_entry(entry);
+}
+
+void MmapVfs::load_children(VfsEntry* entry)
+{
+    if (!entry || entry->children_loaded) {
+        return;
+    }
+
+    entry->children_loaded = true;
+
+    const auto& format = ace3x::format_info(entry_format(entry));
+
+    if (!format.children || !entry->data) {
+        return;
+    }
+
+    try {
+        for (const auto& child : format.children(entry->data, entry->size, entry->name)) {
+            entry->entries.push_back(add_child(entry, entry->data, child));
         }
     }
+    catch (const ValidationError& e) {
+        spdlog::warn("VFS: Not listing the entries of '{}': {}", entry->relative_path, e.what());
+    }
 
-    return nullptr;
+    index_in_background(entry->entries);
+}
+
+VfsEntry* MmapVfs::get_entry(const std::string& absolute_path)
+{
+    const auto it = entries_by_path_.find(absolute_path);
+
+    return it == entries_by_path_.end() ? nullptr : it->second;
 }
 
 void MmapVfs::clear()
 {
+    indexer_.cancel();
     loaded_vpps_.clear();
     entries_.clear();
+    entries_by_path_.clear();
+    entries_by_name_.clear();
+    name_index_.clear();
+    search_directories_.clear();
+    known_directories_.clear();
+    archive_by_name_.clear();
+    missing_names_.clear();
+}
+
+std::vector<VfsEntry*> MmapVfs::search(const std::string& query)
+{
+    add_indexed_children();
+
+    return name_index_.find(query);
+}
+
+void MmapVfs::set_indexed_callback(std::function<void()> callback)
+{
+    const bool enable = !index_in_background_ && callback;
+
+    index_in_background_ = static_cast<bool>(callback);
+    indexer_.set_ready_callback(std::move(callback));
+
+    /* Containers of the archives loaded so far. */
+    if (enable) {
+        std::vector<VfsEntry*> loaded;
+        for (auto& entry : entries_) {
+            loaded.push_back(&entry);
+        }
+        index_in_background(loaded);
+    }
+}
+
+std::size_t MmapVfs::add_indexed_children()
+{
+    std::vector<VfsEntry*> added;
+
+    for (const auto& result : indexer_.take_results()) {
+        VfsEntry* entry = result.container;
+
+        /* Listed by load_children() while queued. */
+        if (entry->children_loaded) {
+            continue;
+        }
+
+        entry->children_loaded = true;
+        entry->format = result.format;
+        entry->format_sniffed = true;
+
+        for (const auto& child : result.children) {
+            entry->entries.push_back(add_child(entry, entry->data, child));
+            added.push_back(entry->entries.back());
+        }
+    }
+
+    /* Containers nested in the new entries go to the back of the queue. */
+    index_in_background(added);
+
+    return added.size();
+}
+
+bool MmapVfs::indexing() const
+{
+    return indexer_.busy();
+}
+
+VfsEntry* MmapVfs::resolve(const std::string& name)
+{
+    if (VfsEntry* entry = find_by_name(name)) {
+        return entry;
+    }
+
+    add_indexed_children();
+
+    if (VfsEntry* entry = find_by_name(name)) {
+        return entry;
+    }
+
+    const auto key = lowercase(name);
+
+    if (missing_names_.count(key)) {
+        return nullptr;
+    }
+
+    index_search_directories();
+
+    /* Only the archive that has the name is loaded. */
+    if (const auto it = archive_by_name_.find(key); it != archive_by_name_.end() && !loaded_vpps_.count(it->second)) {
+        const auto path = it->second;
+
+        try {
+            if (add_root_archive(path)) {
+                spdlog::info("VFS: Loaded '{}' to resolve '{}'", path, name);
+
+                if (archive_loaded_) {
+                    archive_loaded_(get_entry(path));
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            spdlog::warn("VFS: Failed to load '{}' while resolving '{}': {}", path, name, e.what());
+        }
+
+        if (VfsEntry* entry = find_by_name(name)) {
+            return entry;
+        }
+    }
+
+    /* A name nested in a container may still turn up while indexing. */
+    if (!indexing()) {
+        missing_names_.insert(key);
+    }
+
+    return nullptr;
+}
+
+void MmapVfs::add_search_directory(const std::string& path)
+{
+    if (known_directories_.insert(path).second) {
+        search_directories_.push_back(path);
+        missing_names_.clear();
+    }
+}
+
+void MmapVfs::index_search_directories()
+{
+    for (const auto& directory : search_directories_) {
+        std::vector<std::filesystem::path> archives;
+
+        std::error_code error;
+        for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+            const auto extension = file.path().extension().string();
+            if (file.is_regular_file() && (extension == ".vpp" || extension == ".VPP")) {
+                archives.push_back(std::filesystem::absolute(file.path()));
+            }
+        }
+
+        /* Whichever order the directory lists them in, the same archive wins
+         * a name that several have. */
+        std::sort(archives.begin(), archives.end());
+
+        for (const auto& archive : archives) {
+            try {
+                for (const auto& filename : archive_filenames(archive)) {
+                    archive_by_name_.emplace(lowercase(filename), archive.generic_string());
+                }
+            }
+            catch (const std::exception& e) {
+                spdlog::warn("VFS: Not indexing '{}': {}", archive.generic_string(), e.what());
+            }
+        }
+
+        spdlog::info("VFS: Indexed the names in {} archives of '{}'", archives.size(), directory);
+    }
+
+    search_directories_.clear();
+}
+
+void MmapVfs::set_archive_loaded_callback(std::function<void(VfsEntry*)> callback)
+{
+    archive_loaded_ = std::move(callback);
+}
+
+void MmapVfs::index_in_background(const std::vector<VfsEntry*>& entries)
+{
+    if (!index_in_background_) {
+        return;
+    }
+
+    /* Only entries that are containers by extension. Sniffing every entry
+     * would read a page of each, which is most of the IO of listing. */
+    std::vector<ContainerIndexer::Job> jobs;
+    for (VfsEntry* entry : entries) {
+        if (!entry->children_loaded && entry->data && ace3x::format_info(entry->format).children) {
+            jobs.push_back({entry, entry->data, entry->size, entry->name, entry->format});
+        }
+    }
+
+    indexer_.enqueue(std::move(jobs));
+}
+
+VfsEntry* MmapVfs::find_by_name(const std::string& name) const
+{
+    const auto it = entries_by_name_.find(lowercase(name));
+
+    return it == entries_by_name_.end() ? nullptr : it->second;
+}
+
+void MmapVfs::set_access_pattern(AccessPattern pattern)
+{
+    access_pattern_ = pattern;
+
+    for (const auto& [path, vpp] : loaded_vpps_) {
+        advise_access(vpp.mmap.data(), vpp.mmap.mapped_length(), pattern);
+    }
+}
+
+AccessPattern MmapVfs::access_pattern() const
+{
+    return access_pattern_;
+}
+
+void MmapVfs::prefetch(const VfsEntry* entry)
+{
+    if (!entry || !entry->data) {
+        return;
+    }
+
+    prefetch_range(entry->data, entry->size);
+
+    /* A PEG frame is decoded using the header of its PEG. */
+    if (entry->parent && entry->parent->parent) {
+        prefetch_range(entry->parent->data, 1);
+    }
 }
@@ -3,11 +3,16 @@
 
 #include <deque>
 #include <filesystem>
+#include <functional>
 #include <map>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "format-readers/vpp.hpp"
+#include "vfs/container-indexer.hpp"
 #include "vfs/mio.hpp"
+#include "vfs/name-index.hpp"
 #include "vfs/vfs-entry.hpp"
 #include "vfs/vfs.hpp"
 
@@ -23,15 +28,46 @@ public:
     bool add_root_archive(const std::string& path) override;
     VfsEntry* get_entry(const std::string& absolute_path) override;
     void clear() override;
+    void load_children(VfsEntry* entry) override;
+    std::vector<VfsEntry*> search(const std::string& query) override;
+    void set_indexed_callback(std::function<void()> callback) override;
+    std::size_t add_indexed_children() override;
+    bool indexing() const override;
+    VfsEntry* resolve(const std::string& name) override;
+    void add_search_directory(const std::string& path) override;
+    void set_archive_loaded_callback(std::function<void(VfsEntry*)> callback) override;
+    void set_access_pattern(AccessPattern pattern) override;
+    AccessPattern access_pattern() const override;
+    void prefetch(const VfsEntry* entry) override;
 
 private:
     VfsEntry* add_entry(const VfsEntry& entry);
-    bool remap_as_decompressed_vpp(mio::mmap_source& mmap, ace3x::vpp::VppInfo& info);
+    VfsEntry* add_child(VfsEntry* parent, const unsigned char* parent_data, const ace3x::ArchiveEntry& archive_entry);
+    bool remap_as_decompressed_vpp(mio::mmap_source& mmap, ace3x::vpp::VppInfo& info, const std::string& cache_name);
     bool map_file(mio::mmap_source& mmap, const std::filesystem::path& path);
+    void index_in_background(const std::vector<VfsEntry*>& entries);
+    void index_search_directories();
+    VfsEntry* find_by_name(const std::string& name) const;
 
 private:
     std::unordered_map<std::string, VppFile> loaded_vpps_;
     std::deque<VfsEntry> entries_;
+    std::unordered_map<std::string, VfsEntry*> entries_by_path_;
+    /* Sort key -> first entry of that name. The keys point into entries_. */
+    std::unordered_map<std::string_view, VfsEntry*> entries_by_name_;
+    NameIndex name_index_;
+    AccessPattern access_pattern_ {AccessPattern::Normal};
+    bool index_in_background_ {false};
+    /* For resolve(): directories not indexed yet, and the lowercase names
+     * in the archives of those indexed -> path of the first archive with it. */
+    std::vector<std::string> search_directories_;
+    std::unordered_set<std::string> known_directories_;
+    std::unordered_map<std::string, std::string> archive_by_name_;
+    /* Lowercase names resolve() found nowhere. Dropped when entries are added. */
+    std::unordered_set<std::string> missing_names_;
+    std::function<void(VfsEntry*)> archive_loaded_;
+    /* Last, so its thread is stopped before the archives are unmapped. */
+    ContainerIndexer indexer_;
 };
 
 #endif    // ACE3X_VFS_MMAP_VFS_HPP_
@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "vfs/name-index.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <optional>
+
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+std::string to_lower(std::string_view str)
+{
+    std::string lower(str);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return lower;
+}
+
+std::uint32_t trigram(std::string_view str, std::size_t pos)
+{
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(str[pos + 0])) << 16) |
+           (static_cast<std::uint32_t>(static_cast<unsigned char>(str[pos + 1])) << 8) |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(str[pos + 2]));
+}
+
+bool glob_match(std::string_view name, std::string_view pattern)
+{
+    std::size_t n = 0;
+    std::size_t p = 0;
+    std::size_t star = std::string_view::npos;
+    std::size_t star_n = 0;
+
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            n++;
+            p++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_n = n;
+        }
+        else if (star != std::string_view::npos) {
+            p = star + 1;
+            n = ++star_n;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+
+    return p == pattern.size();
+}
+
+std::vector<std::uint32_t> intersect(const std::vector<std::uint32_t> &a, const std::vector<std::uint32_t> &b)
+{
+    std::vector<std::uint32_t> result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+}    // namespace
+
+void NameIndex::add(VfsEntry *entry)
+{
+    const auto id = static_cast<std::uint32_t>(entries_.size());
+
+    entries_.push_back(entry);
+    names_.push_back(entry->sort_key);
+
+    const std::string_view name = names_.back();
+
+    for (std::size_t i = 0; i + 3 <= name.size(); i++) {
+        auto &postings = trigrams_[trigram(name, i)];
+        /* Ids only increase, so this is enough to skip repeats within a name. */
+        if (postings.empty() || postings.back() != id) {
+            postings.push_back(id);
+        }
+    }
+
+    extensions_[entry->extension].push_back(id);
+}
+
+void NameIndex::clear()
+{
+    entries_.clear();
+    names_.clear();
+    trigrams_.clear();
+    extensions_.clear();
+}
+
+std::vector<VfsEntry *> NameIndex::find(std::string_view query) const
+{
+    std::optional<Postings> matches;
+
+    std::size_t pos = 0;
+    while (pos < query.size()) {
+        const auto start = query.find_first_not_of(" \t", pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        auto end = query.find_first_of(" \t", start);
+        if (end == std::string_view::npos) {
+            end = query.size();
+        }
+        pos = end;
+
+        const auto term = to_lower(query.substr(start, end - start));
+
+        Postings term_matches;
+        if (term.rfind("ext:", 0) == 0) {
+            term_matches = find_extension(std::string_view(term).substr(4));
+        }
+        else if (term.find_first_of("*?") != std::string::npos) {
+            term_matches = find_glob(term);
+        }
+        else {
+            term_matches = find_substring(term);
+        }
+
+        matches = matches ? intersect(*matches, term_matches) : std::move(term_matches);
+
+        if (matches->empty()) {
+            break;
+        }
+    }
+
+    std::vector<VfsEntry *> result;
+    if (matches) {
+        result.reserve(matches->size());
+        for (const auto id : *matches) {
+            result.push_back(entries_[id]);
+        }
+    }
+
+    return result;
+}
+
+NameIndex::Postings NameIndex::find_substring(std::string_view needle) const
+{
+    if (needle.size() < 3) {
+        return scan(needle);
+    }
+
+    /* Intersect the rarest trigrams first, then confirm, since a name can
+     * contain every trigram of the needle without containing the needle. */
+    std::vector<const Postings *> lists;
+    for (std::size_t i = 0; i + 3 <= needle.size(); i++) {
+        const auto it = trigrams_.find(trigram(needle, i));
+        if (it == trigrams_.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const Postings *a, const Postings *b) {
+        return a->size() < b->size();
+    });
+
+    Postings candidates = *lists.front();
+    for (std::size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        candidates = intersect(candidates, *lists[i]);
+    }
+
+    Postings result;
+    for (const auto id : candidates) {
+        if (names_[id].find(needle) != std::string::npos) {
+            result.push_back(id);
+        }
+    }
+
+    return result;
+}
+
+NameIndex::Postings NameIndex::find_glob(std::string_view pattern) const
+{
+    std::optional<Postings> candidates;
+
+    /* "*.ext" is common enough to go straight to the extension lists. */
+    if (pattern.size() > 2 && pattern.substr(0, 2) == "*." && pattern.find_first_of("*?", 1) == std::string_view::npos) {
+        return find_extension(pattern.substr(2));
+    }
+
+    /* Narrow down with the literal runs between wildcards. */
+    std::size_t pos = 0;
+    while (pos < pattern.size()) {
+        const auto start = pattern.find_first_not_of("*?", pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        auto end = pattern.find_first_of("*?", start);
+        if (end == std::string_view::npos) {
+            end = pattern.size();
+        }
+        pos = end;
+
+        if (end - start >= 3) {
+            auto run = find_substring(pattern.substr(start, end - start));
+            candidates = candidates ? intersect(*candidates, run) : std::move(run);
+        }
+    }
+
+    Postings result;
+
+    if (candidates) {
+        for (const auto id : *candidates) {
+            if (glob_match(names_[id], pattern)) {
+                result.push_back(id);
+            }
+        }
+    }
+    else {
+        for (std::uint32_t id = 0; id < names_.size(); id++) {
+            if (glob_match(names_[id], pattern)) {
+                result.push_back(id);
+            }
+        }
+    }
+
+    return result;
+}
+
+NameIndex::Postings NameIndex::find_extension(std::string_view extension) const
+{
+    if (!extension.empty() && extension.front() == '.') {
+        extension.remove_prefix(1);
+    }
+
+    const auto it = extensions_.find('.' + std::string(extension));
+
+    return it == extensions_.end() ? Postings() : it->second;
+}
+
+NameIndex::Postings NameIndex::scan(std::string_view needle) const
+{
+    Postings result;
+
+    for (std::uint32_t id = 0; id < names_.size(); id++) {
+        if (names_[id].find(needle) != std::string::npos) {
+            result.push_back(id);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_VFS_NAME_INDEX_HPP_
+#define ACE3X_VFS_NAME_INDEX_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct VfsEntry;
+
+/* Trigram index over entry names, built as archives are loaded.
+ *
+ * Queries are whitespace separated terms which must all match, case insensitive:
+ *   foo        name contains "foo"
+ *   ext:peg    extension is .peg
+ *   *_s?.tga   glob over the whole name
+ */
+class NameIndex {
+public:
+    void add(VfsEntry *entry);
+    void clear();
+
+    std::vector<VfsEntry *> find(std::string_view query) const;
+
+private:
+    using Postings = std::vector<std::uint32_t>;
+
+    Postings find_substring(std::string_view needle) const;
+    Postings find_glob(std::string_view pattern) const;
+    Postings find_extension(std::string_view extension) const;
+    Postings scan(std::string_view needle) const;
+
+private:
+    std::vector<VfsEntry *> entries_;
+    std::vector<std::string_view> names_;    // entry sort keys, parallel to entries_
+    std::unordered_map<std::uint32_t, Postings> trigrams_;
+    std::unordered_map<std::string, Postings> extensions_;
+};
+
+#endif    // ACE3X_VFS_NAME_INDEX_HPP_
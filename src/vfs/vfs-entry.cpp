@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "vfs/vfs-entry.hpp"
+
+#include "format-readers/registry.hpp"
+
+ace3x::FormatId entry_format(const VfsEntry* entry)
+{
+    if (!entry->format_sniffed) {
+        entry->format = ace3x::sniff_format(entry->data, entry->size, entry->format);
+        entry->format_sniffed = true;
+    }
+
+    return entry->format;
+}
@@ -1,22 +1,35 @@
 #ifndef ACE3X_VFS_VFS_ENTRY_HPP_
 #define ACE3X_VFS_VFS_ENTRY_HPP_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "format-readers/format-id.hpp"
+
 struct VfsEntry {
     int index;
     std::uintmax_t size;
-    std::size_t offset_in_parent;
-    std::size_t offset_in_root;
+    std::uint64_t offset_in_parent;
+    std::uint64_t offset_in_root;
     std::string name;
+    std::string sort_key;    // lowercase name, filled in by the VFS
     std::string absolute_path;
     std::string relative_path;
     std::string extension;
+    /* Guessed from the extension when added; read it through entry_format(),
+     * which checks it against the entry's first bytes on first use. */
+    mutable ace3x::FormatId format {ace3x::FormatId::Unknown};
+    mutable bool format_sniffed {false};
+    bool children_loaded {false};                         // see Vfs::load_children
     std::vector<VfsEntry*> entries;
     VfsEntry* root;
     VfsEntry* parent;
     const unsigned char* data;
 };
 
+/* The entry's format, sniffed from its data the first time and cached, so
+ * listing an archive never touches the entries themselves. */
+ace3x::FormatId entry_format(const VfsEntry* entry);
+
 #endif    // ACE3X_VFS_VFS_ENTRY_HPP_
@@ -1,17 +1,60 @@
 #ifndef ACE3X_VFS_VFS_HPP_
 #define ACE3X_VFS_VFS_HPP_
 
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <vector>
+
+#include "vfs/advice.hpp"
 
 struct VfsEntry;
 
 class Vfs {
 public:
-    ~Vfs() = default;
+    virtual ~Vfs() = default;
 
     virtual bool add_root_archive(const std::string& path) = 0;
     virtual VfsEntry* get_entry(const std::string& absolute_path) = 0;
     virtual void clear() = 0;
+
+    /* Lists the entries nested in a container such as a PEG, using the reader
+     * registered for its format. Does nothing if they are already listed, so
+     * call it before reading entry->entries of anything but an archive. */
+    virtual void load_children(VfsEntry* entry) = 0;
+
+    /* Entries of all loaded archives matching a NameIndex query. Entries
+     * nested in containers are found once listed, by load_children() or in
+     * the background; while indexing() the results may be partial. */
+    virtual std::vector<VfsEntry*> search(const std::string& query) = 0;
+
+    /* Once set, the containers of loaded archives are listed on a background
+     * thread. The callback runs on that thread when listed children are
+     * waiting; it should get add_indexed_children() called on the thread
+     * using the VFS. An empty callback stops further calls. */
+    virtual void set_indexed_callback(std::function<void()> callback) = 0;
+    /* Adds the children listed in the background so far, returns how many. */
+    virtual std::size_t add_indexed_children() = 0;
+    /* Whether containers are still waiting to be listed in the background. */
+    virtual bool indexing() const = 0;
+
+    /* Finds an entry by file name alone, case insensitive, e.g. a texture
+     * named by a mesh. On a miss, only the search directory archive listing
+     * the name is loaded. Names nested in containers are only found once
+     * listed. Returns nullptr if none has it; such misses are remembered
+     * until entries are added. */
+    virtual VfsEntry* resolve(const std::string& name) = 0;
+    /* Archives in path that resolve() may load. Their names are indexed on
+     * the first miss, reading only each header and filenames block. */
+    virtual void add_search_directory(const std::string& path) = 0;
+    /* Called with each archive resolve() loads, e.g. to show it. */
+    virtual void set_archive_loaded_callback(std::function<void(VfsEntry*)> callback) = 0;
+
+    /* Applies to every loaded archive and to archives loaded later. */
+    virtual void set_access_pattern(AccessPattern pattern) = 0;
+    virtual AccessPattern access_pattern() const = 0;
+    /* Starts reading the entry's bytes in the background, e.g. when it is selected. */
+    virtual void prefetch(const VfsEntry* entry) = 0;
 };
 
 #endif    // ACE3X_VFS_VFS_HPP_
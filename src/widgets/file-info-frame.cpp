@@ -14,7 +14,9 @@
 #include <QPushButton>
 
 #include "ui_file-info-frame.h"
+#include "vfs/advice.hpp"
 #include "vfs/vfs-entry.hpp"
+#include "vfs/vfs.hpp"
 #include "widgets/format-viewers/viewer.hpp"
 
 FileInfoFrame::FileInfoFrame(QWidget *parent)
@@ -27,6 +29,11 @@ FileInfoFrame::FileInfoFrame(QWidget *parent)
     connect(ui->view_btn, &QPushButton::released, this, &FileInfoFrame::view_btn_clicked);
 }
 
+void FileInfoFrame::set_vfs(Vfs *vfs)
+{
+    vfs_ = vfs;
+}
+
 void FileInfoFrame::set_item(VfsEntry *item)
 {
     item_ = item;
@@ -56,6 +63,9 @@ void FileInfoFrame::save_btn_clicked()
         return;
     }
 
+    advise_access(item_->data, item_->size, AccessPattern::Sequential);
+    prefetch_range(item_->data, item_->size);
+
     QFile file(filename);
 
     if (false == file.open(QIODevice::WriteOnly)) {
@@ -67,6 +77,9 @@ void FileInfoFrame::save_btn_clicked()
     else {
         spdlog::info("Wrote file '{}'", filename.toStdString());
     }
+
+    /* Back to the pattern the VFS applies to the rest of the archive. */
+    advise_access(item_->data, item_->size, vfs_ ? vfs_->access_pattern() : AccessPattern::Normal);
 }
 
 void FileInfoFrame::view_btn_clicked()
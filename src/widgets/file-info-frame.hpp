@@ -10,6 +10,7 @@ class QPushButton;
 class QLineEdit;
 
 class Viewer;
+class Vfs;
 struct VfsEntry;
 
 class Ui_FileInfoFrame;
@@ -19,6 +20,8 @@ class FileInfoFrame : public QWidget {
 public:
     FileInfoFrame(QWidget *parent = nullptr);
 
+    /* The VFS whose access pattern is restored after a save. */
+    void set_vfs(Vfs *vfs);
     void enable_view();
     void clear();
 
@@ -35,6 +38,7 @@ private slots:
 
 private:
     Ui_FileInfoFrame *ui;
+    Vfs *vfs_ {nullptr};
     VfsEntry *item_ {nullptr};
 };
 
@@ -4,21 +4,53 @@
 
 #include <spdlog/spdlog.h>
 
+#include <QComboBox>
 #include <QDir>
 #include <QFileDialog>
 #include <QImage>
 #include <QKeyEvent>
+#include <algorithm>
 
+#include "format-readers/peg-texture-decoder.hpp"
 #include "format-readers/peg.hpp"
+#include "imaging/downscale.hpp"
 #include "ui_image-viewer.h"
 #include "vfs/vfs-entry.hpp"
+#include "widgets/thumbnail-grid.hpp"
 
 ImageViewer::ImageViewer(QWidget *parent)
     : Viewer(parent)
     , ui_(new Ui::ImageViewer())
+    , grid_(new ThumbnailGrid())
 {
     ui_->setupUi(this);
 
+    /* The grid takes the place of the single frame view when toggled. */
+    grid_->hide();
+    ui_->gridLayout_2->addWidget(grid_, 1, 0);
+
+    auto *grid_button = new QPushButton("Grid");
+    grid_button->setCheckable(true);
+    ui_->horizontalLayout->addWidget(grid_button);
+
+    /* Zoomed out views are mip levels built with our own box filter rather
+     * than Qt's smooth transform, which is slow on large frames. */
+    auto *zoom = new QComboBox();
+    zoom->addItems({"100%", "50%", "25%", "12.5%"});
+    ui_->horizontalLayout_3->addWidget(new QLabel("Zoom"));
+    ui_->horizontalLayout_3->addWidget(zoom);
+
+    connect(zoom, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        zoom_level_ = index;
+        presentFrame();
+    });
+    connect(grid_button, &QPushButton::toggled, this, &ImageViewer::setGridVisible);
+    connect(grid_, &ThumbnailGrid::frame_activated, this, [this, grid_button](const VfsEntry *frame) {
+        selectFrame(frame);
+        grid_button->setChecked(false);
+        updateImage();
+    });
+
     connect(ui_->prev, &QPushButton::pressed, this, [this]() {
         prevFrame();
     });
@@ -48,8 +80,8 @@ ImageViewer::ImageViewer(QWidget *parent)
         updateImage();
     });
     connect(ui_->brightness, &QSlider::valueChanged, this, [this]() {
-        auto rgb = ui_->brightness->value() / 100.0f * 255.0f;
-        ui_->image_label->setStyleSheet(QString("background-color:rgb(%1,%2,%3)").arg(rgb).arg(rgb).arg(rgb));
+        const int rgb = static_cast<int>(ui_->brightness->value() / 100.0f * 255.0f);
+        ui_->canvas->set_background(QColor(rgb, rgb, rgb));
     });
     ui_->brightness->setValue(49);
 }
@@ -60,25 +92,51 @@ void ImageViewer::activate(const VfsEntry *item)
 
     show();
 
-    if (item->extension == ".peg") {
+    if (entry_format(item) == ace3x::FormatId::Peg) {
         current_frame_index_ = 0;
         peg_ = item;
     }
-    else if (item->parent && (item->parent->extension == ".peg")) {
-        current_frame_index_ = item->index;
+    else if (item->parent && (entry_format(item->parent) == ace3x::FormatId::Peg)) {
         peg_ = item->parent;
+        selectFrame(item);
     }
 
     assert(peg_);
-    assert(current_frame_index_ < peg_->entries.size());
-
-    images_ = ace3x::peg::get_images(peg_->data);
 
     ui_->image_max->setText(QString::number(peg_->entries.size()));
 
+    if (!grid_->isHidden()) {
+        grid_->set_pegs({peg_});
+    }
+
     updateImage();
 }
 
+void ImageViewer::clear()
+{
+    grid_->clear();
+    ui_->canvas->clear();
+    peg_ = nullptr;
+}
+
+/* current_frame_index_ indexes peg_->entries, which may skip frames of the
+ * PEG, so it is not the same as the frame's own index. */
+void ImageViewer::selectFrame(const VfsEntry *frame)
+{
+    const auto it = std::find(peg_->entries.begin(), peg_->entries.end(), frame);
+    current_frame_index_ = (it == peg_->entries.end()) ? 0 : static_cast<std::size_t>(it - peg_->entries.begin());
+}
+
+void ImageViewer::setGridVisible(bool visible)
+{
+    if (visible && peg_) {
+        grid_->set_pegs({peg_});
+    }
+
+    grid_->setVisible(visible);
+    ui_->scrollArea->setVisible(!visible);
+}
+
 void ImageViewer::keyPressEvent(QKeyEvent *event)
 {
     QWidget::keyPressEvent(event);
@@ -119,20 +177,49 @@ void ImageViewer::prevFrame()
 
 void ImageViewer::updateImage()
 {
-    const auto &peg_image = images_[current_frame_index_];
-    const auto qt_image = QImage(reinterpret_cast<const unsigned char *>(peg_image.pixels.data()), peg_image.width, peg_image.height, QImage::Format_ARGB32);
+    if (!peg_ || current_frame_index_ >= peg_->entries.size()) {
+        return;
+    }
+
+    const auto *entry = peg_->entries[current_frame_index_];
+    const auto frame = ace3x::peg::get_frame_info(peg_->data, entry->index);
 
-    current_frame_name_ = QString::fromStdString(peg_image.filename);
+    if (frame.offset + ace3x::peg::payload_size(frame.format, frame.width, frame.height) > peg_->size) {
+        spdlog::error("Image viewer: Frame '{}' exceeds '{}'", entry->name, peg_->relative_path);
+
+        /* Nothing of the previous frame may stay up, or be zoomed or saved. */
+        frame_width_ = 0;
+        frame_height_ = 0;
+        current_frame_name_.clear();
+        ui_->canvas->clear();
+        ui_->image_name->clear();
+        ui_->image_size->clear();
+        ui_->image_index->clear();
+        ui_->raw_format->clear();
+        ui_->dimensions->clear();
+        ui_->format->clear();
+        return;
+    }
+
+    frame_width_ = frame.width;
+    frame_height_ = frame.height;
+
+    auto *pixels = frame_buffer_.reserve(static_cast<std::size_t>(frame.width) * frame.height);
+    ace3x::peg::decode(pixels, peg_->data + frame.offset, frame.width, frame.height, frame.format);
+
+    current_frame_name_ = QString::fromLatin1(frame.filename.data(), static_cast<int>(frame.filename.size()));
 
     ui_->image_name->setText(QString::fromStdString(peg_->entries[current_frame_index_]->name));
     ui_->image_size->setText(QLocale::system().formattedDataSize(peg_->entries[current_frame_index_]->size, 2, nullptr));
     ui_->image_index->setText(QString::number(current_frame_index_ + 1));
-    ui_->image_label->setPixmap(QPixmap::fromImage(qt_image));
-    ui_->raw_format->setText(QString::number(peg_image.format, 16));
-    ui_->dimensions->setText(QString("%1x%2").arg(peg_image.width).arg(peg_image.height));
+    ui_->raw_format->setText(QString::number(frame.format, 16));
+    ui_->dimensions->setText(QString("%1x%2").arg(frame.width).arg(frame.height));
 
     QString format_name;
-    switch (peg_image.format) {
+    switch (frame.format) {
+        case 0x2:
+            format_name = "Alpha 8";
+            break;
         case 0x3:
             format_name = "RGBA 5551";
             break;
@@ -142,6 +229,9 @@ void ImageViewer::updateImage()
         case 0x104:
             format_name = "RGBA 5551 Indexed";
             break;
+        case 0x105:
+            format_name = "RGBA 5551 Indexed 4-bit";
+            break;
         case 0x204:
             format_name = "RGBA 32 Indexed";
             break;
@@ -151,26 +241,62 @@ void ImageViewer::updateImage()
     }
 
     ui_->format->setText(format_name);
+
+    presentFrame();
+}
+
+void ImageViewer::presentFrame()
+{
+    if (frame_width_ == 0 || frame_height_ == 0) {
+        ui_->canvas->clear();
+        return;
+    }
+
+    const std::uint32_t *pixels = frame_buffer_.data();
+    int width = frame_width_;
+    int height = frame_height_;
+
+    /* Stops at 1x1, so this shows the nearest available level. */
+    for (int level = 0; level < zoom_level_ && (width > 1 || height > 1); level++) {
+        const int half_width = (width + 1) / 2;
+        const int half_height = (height + 1) / 2;
+
+        auto *half = mip_buffers_[level % 2].reserve(static_cast<std::size_t>(half_width) * half_height);
+        ace3x::imaging::downscale_half(half, pixels, width, height);
+
+        pixels = half;
+        width = half_width;
+        height = half_height;
+    }
+
+    ui_->canvas->set_frame(pixels, width, height);
 }
 
 bool ImageViewer::shouldBeEnabled(const VfsEntry *item) const
 {
-    return item->extension == ".peg" || (item->parent && item->parent->extension == ".peg");
+    return entry_format(item) == ace3x::FormatId::Peg || (item->parent && entry_format(item->parent) == ace3x::FormatId::Peg);
 }
 
 void ImageViewer::saveFrame()
 {
+    if (frame_width_ == 0 || frame_height_ == 0) {
+        return;
+    }
+
     const auto fileName = QFileDialog::getSaveFileName(this, "Save File", QDir::currentPath() + '/' + current_frame_name_ + ".png");
     if (fileName.isEmpty()) {
         return;
     }
 
+    /* Straight from the decoded buffer, always full size whatever the zoom. */
+    const auto qt_image = QImage(reinterpret_cast<const unsigned char *>(frame_buffer_.data()), frame_width_, frame_height_, QImage::Format_ARGB32);
+
     QFile file(fileName);
 
     if (false == file.open(QIODevice::WriteOnly)) {
         spdlog::error("Image viewer: Failed to open file for writing: '{}'", fileName.toStdString());
     }
-    else if (!ui_->image_label->pixmap()->save(fileName, "PNG")) {
+    else if (!qt_image.save(&file, "PNG")) {
         spdlog::error("Image viewer: Failed to write data for '{}'", fileName.toStdString());
     }
     else {
@@ -4,17 +4,17 @@
 #define ACE3X_WIDGETS_FORMAT_VIEWERS_IMAGE_VIEWER_HPP_
 
 #include <QWidget>
+#include <array>
 #include <memory>
 
+#include "imaging/aligned-buffer.hpp"
 #include "widgets/format-viewers/viewer.hpp"
 
 namespace Ui {
 class ImageViewer;
 }
 
-namespace ace3x::peg {
-struct Image;
-}
+class ThumbnailGrid;
 
 class ImageViewer : public Viewer {
     Q_OBJECT
@@ -23,22 +23,35 @@ public:
 
     void activate(const VfsEntry *item) override;
     bool shouldBeEnabled(const VfsEntry *item) const override;
+    void clear() override;
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
+    void selectFrame(const VfsEntry *frame);
     void updateImage();
+    void presentFrame();
     void nextFrame();
     void prevFrame();
     void saveFrame();
+    void setGridVisible(bool visible);
 
 private:
     std::unique_ptr<Ui::ImageViewer> ui_;
     const VfsEntry *peg_ {nullptr};
     std::size_t current_frame_index_ {0};
     QString current_frame_name_;
-    std::vector<ace3x::peg::Image> images_;
+    /* Reused from frame to frame, so flipping through a PEG stops allocating
+     * once the largest frame has been seen. Mip levels ping-pong between the
+     * two scratch buffers. */
+    ace3x::imaging::AlignedPixelBuffer frame_buffer_;
+    std::array<ace3x::imaging::AlignedPixelBuffer, 2> mip_buffers_;
+    int frame_width_ {0};
+    int frame_height_ {0};
+    ThumbnailGrid *grid_;
+    /* 0 is full size, n shows mip level n (1/2^n). */
+    int zoom_level_ {0};
 };
 
 #endif    // ACE3X_WIDGETS_FORMAT_VIEWERS_IMAGE_VIEWER_HPP_
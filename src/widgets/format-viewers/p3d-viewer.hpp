@@ -5,7 +5,9 @@
 
 #include <QWidget>
 #include <memory>
+#include <vector>
 
+#include "format-readers/p3d.hpp"
 #include "formats/p3d.hpp"
 #include "widgets/format-viewers/viewer.hpp"
 
@@ -15,6 +17,10 @@ namespace Ui {
 class P3DViewer;
 }
 
+class MeshCanvas;
+class QSortFilterProxyModel;
+class StructTableModel;
+
 struct P3DHeader;
 
 class P3DViewer : public Viewer {
@@ -24,20 +30,24 @@ public:
 
     void activate(const VfsEntry *item) override;
     bool shouldBeEnabled(const VfsEntry *item) const override;
+    void clear() override;
 
 private:
-    void write_vertices(const QString &fileName, const P3DHeader &header, const unsigned char *const item_data);
-    void load_navpoints(const unsigned char *data, u32 count, u32 offset);
-    void load_layers(const unsigned char *data, u32 count, u32 offset);
+    void write_vertices(const QString &fileName);
+    void load_navpoints(const std::vector<ace3x::p3d::Navpoint> &navpoints);
+    void load_layers(const std::vector<ace3x::p3d::Layer> &layers);
 
 private slots:
     void onWriteObjClicked();
 
 private:
     std::unique_ptr<Ui::P3DViewer> ui_;
+    MeshCanvas *canvas_;
     const VfsEntry *item_ {nullptr};
+    StructTableModel *navpoint_model_;
+    QSortFilterProxyModel *navpoint_proxy_;
+    StructTableModel *layer_model_;
     P3DHeader header_;
-    std::vector<P3DNavpoint> navpoints_;
 };
 
 #endif    // ACE3X_WIDGETS_FORMAT_VIEWERS_P3D_VIEWER_HPP_
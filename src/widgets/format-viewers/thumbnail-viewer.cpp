@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "widgets/format-viewers/thumbnail-viewer.hpp"
+
+#include <QVBoxLayout>
+
+#include "vfs/vfs-entry.hpp"
+#include "vfs/vfs.hpp"
+#include "widgets/thumbnail-grid.hpp"
+
+ThumbnailViewer::ThumbnailViewer(Vfs *vfs, QWidget *parent)
+    : Viewer(parent)
+    , vfs_(vfs)
+    , grid_(new ThumbnailGrid())
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(grid_);
+}
+
+void ThumbnailViewer::activate(const VfsEntry *item)
+{
+    assert(item);
+
+    show();
+
+    std::vector<const VfsEntry *> pegs;
+    for (auto *entry : item->entries) {
+        if (entry_format(entry) == ace3x::FormatId::Peg) {
+            vfs_->load_children(entry);
+            pegs.push_back(entry);
+        }
+    }
+
+    grid_->set_pegs(pegs);
+}
+
+bool ThumbnailViewer::shouldBeEnabled(const VfsEntry *item) const
+{
+    return entry_format(item) == ace3x::FormatId::Vpp;
+}
+
+void ThumbnailViewer::clear()
+{
+    grid_->clear();
+}
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_WIDGETS_FORMAT_VIEWERS_THUMBNAIL_VIEWER_HPP_
+#define ACE3X_WIDGETS_FORMAT_VIEWERS_THUMBNAIL_VIEWER_HPP_
+
+#include <QWidget>
+
+#include "widgets/format-viewers/viewer.hpp"
+
+class ThumbnailGrid;
+class Vfs;
+
+/* Thumbnails of every PEG frame in an archive. */
+class ThumbnailViewer : public Viewer {
+    Q_OBJECT
+public:
+    explicit ThumbnailViewer(Vfs *vfs, QWidget *parent = nullptr);
+
+    void activate(const VfsEntry *item) override;
+    bool shouldBeEnabled(const VfsEntry *item) const override;
+    void clear() override;
+
+private:
+    Vfs *vfs_;
+    ThumbnailGrid *grid_;
+};
+
+#endif    // ACE3X_WIDGETS_FORMAT_VIEWERS_THUMBNAIL_VIEWER_HPP_
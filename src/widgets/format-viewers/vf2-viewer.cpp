@@ -4,13 +4,17 @@
 
 #include <spdlog/spdlog.h>
 
+#include <QGraphicsPixmapItem>
+#include <QEvent>
 #include <QGraphicsScene>
-#include <QGraphicsSimpleTextItem>
-#include <filesystem>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+#include <algorithm>
 
 #include "format-readers/peg.hpp"
+#include "format-readers/validation-error.hpp"
 #include "format-readers/vf2.hpp"
-#include "formats/vf2.hpp"
 #include "ui_vf2-viewer.h"
 #include "vfs/vfs-entry.hpp"
 #include "vfs/vfs.hpp"
@@ -24,13 +28,32 @@ Vf2Viewer::Vf2Viewer(Vfs *vfs, QWidget *parent)
     , ui_(new Ui::Vf2Viewer())
     , vfs_(vfs)
     , font_scene_(new QGraphicsScene(this))
-    , font_pixmap_(new QPixmap())
+    , preview_item_(font_scene_->addPixmap(QPixmap()))
+    , preview_timer_(new QTimer(this))
 {
     ui_->setupUi(this);
 
     ui_->graphicsView->setScene(font_scene_);
 
-    connect(ui_->plainTextEdit, &QPlainTextEdit::textChanged, this, &Vf2Viewer::update_font_scene);
+    /* Renders once per event loop pass, however many edits came in. */
+    preview_timer_->setSingleShot(true);
+    preview_timer_->setInterval(0);
+    connect(ui_->plainTextEdit, &QPlainTextEdit::textChanged, preview_timer_, QOverload<>::of(&QTimer::start));
+    connect(preview_timer_, &QTimer::timeout, this, &Vf2Viewer::update_font_scene);
+
+    /* Only the glyphs in view are drawn, so scrolling and resizing draw again. */
+    connect(ui_->graphicsView->horizontalScrollBar(), &QScrollBar::valueChanged, this, &Vf2Viewer::draw_visible_glyphs);
+    connect(ui_->graphicsView->verticalScrollBar(), &QScrollBar::valueChanged, this, &Vf2Viewer::draw_visible_glyphs);
+    ui_->graphicsView->viewport()->installEventFilter(this);
+}
+
+bool Vf2Viewer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui_->graphicsView->viewport() && event->type() == QEvent::Resize) {
+        draw_visible_glyphs();
+    }
+
+    return Viewer::eventFilter(watched, event);
 }
 
 void Vf2Viewer::activate(const VfsEntry *item)
@@ -39,144 +62,198 @@ void Vf2Viewer::activate(const VfsEntry *item)
 
     ui_->tabWidget->setCurrentIndex(0);
     ui_->tab_2->setEnabled(false);
+    ui_->image_label->clear();
+    ui_->chars->clear();
+    ui_->chars->setRowCount(0);
 
-    Vf2Header header;
-    std::memcpy(&header, item->data, sizeof(header));
+    atlas_ = load_atlas(item);
 
-    font_height_ = header.height;
-    first_ascii_ = header.first_ascii;
+    if (!atlas_) {
+        return;
+    }
+
+    const auto &header = atlas_->font.header;
+    const auto &chars = atlas_->font.chars;
 
     ui_->signature->setText(QString::fromLocal8Bit(QByteArray::fromRawData((const char *)(&header.signature), 4)));
     ui_->version->setText(QString::number(header.version));
     ui_->num_chars->setText(QString::number(header.num_chars));
     ui_->height->setText(QString::number(header.height));
 
-    ui_->chars->clear();
     ui_->chars->setColumnCount(4);
-    ui_->chars->setHorizontalHeaderLabels({"Min Width", "Max Width", "Pixel Offset", "Kerning Backspace"});
-    ui_->chars->setRowCount(header.num_chars);
+    ui_->chars->setHorizontalHeaderLabels({"Spacing", "Width", "Pixel Offset", "First Kerning Pair"});
+    ui_->chars->setRowCount(static_cast<int>(chars.size()));
     ui_->chars->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
-    ui_->image_label->clear();
+    for (auto i = 0u; i < chars.size(); i++) {
+        ui_->chars->setVerticalHeaderItem(i, new QTableWidgetItem(QChar(header.first_ascii + i)));
+        ui_->chars->setItem(i, 0, new QTableWidgetItem(QString::number(chars[i].spacing)));
+        ui_->chars->setItem(i, 1, new QTableWidgetItem(QString::number(chars[i].width)));
+        ui_->chars->setItem(i, 2, new QTableWidgetItem(QString::number(chars[i].pixel_data_offset, 16)));
+        ui_->chars->setItem(i, 3, new QTableWidgetItem(chars[i].first_kerning_entry == 0xFFFF ? "None" : QString::number(chars[i].first_kerning_entry)));
+    }
 
-    std::uint64_t chars_offset = sizeof(header);
-    while (chars_offset + 4u < item->size) {
-        std::uint32_t value {0};
-        std::memcpy(&value, item->data + chars_offset, 4);
-        if (value == 0xFFFF) {
-            break;
-        }
-        chars_offset += 4;
+    if (atlas_->glyph_rects.empty()) {
+        return;
     }
-    chars_offset -= 12;
 
-    std::uint64_t chars_size = sizeof(FontChar) * header.num_chars;
+    ui_->image_label->setPixmap(QPixmap::fromImage(atlas_->image));
+    ui_->plainTextEdit->clear();
+    ui_->tab_2->setEnabled(true);
+}
 
-    if (chars_size + chars_offset >= item->size) {
-        return;
+bool Vf2Viewer::shouldBeEnabled(const VfsEntry *) const
+{
+    return true;
+}
+
+void Vf2Viewer::clear()
+{
+    atlas_ = nullptr;
+    atlases_.clear();
+    placed_.clear();
+    preview_ = QImage();
+    preview_item_->setPixmap(QPixmap());
+    ui_->image_label->clear();
+}
+
+const Vf2Viewer::FontAtlas *Vf2Viewer::load_atlas(const VfsEntry *item)
+{
+    if (const auto it = atlases_.find(item->absolute_path); it != atlases_.end()) {
+        return &it->second;
     }
 
-    std::vector<FontChar> chars(header.num_chars);
-    std::memcpy(chars.data(), item->data + chars_offset, chars_size);
+    FontAtlas atlas;
 
-    for (auto i = 0u; i < header.num_chars; i++) {
-        ui_->chars->setVerticalHeaderItem(i, new QTableWidgetItem(QChar(header.first_ascii + i)));
-        ui_->chars->setItem(i, 0, new QTableWidgetItem(QString::number(chars[i].min_width)));
-        ui_->chars->setItem(i, 1, new QTableWidgetItem(QString::number(chars[i].max_width)));
-        ui_->chars->setItem(i, 2, new QTableWidgetItem(QString::number(chars[i].pixel_offset, 16)));
-        ui_->chars->setItem(i, 3, new QTableWidgetItem(chars[i].kerning_back_pixels_width == 0xFFFF ? "None" : QString::number(chars[i].kerning_back_pixels_width)));
+    try {
+        atlas.font = ace3x::vf2::read(item->data, item->size, item->name);
+        atlas.kerning = ace3x::vf2::KerningTable(atlas.font);
     }
+    catch (const ValidationError &e) {
+        spdlog::error("{}", e.what());
+        return nullptr;
+    }
+
+    /* Cached even without its texture, which can still be inspected. */
+    load_texture(item, atlas);
 
-    const auto summoner_path = std::filesystem::path(item->root->absolute_path).parent_path().generic_string() + '/' + "SUMMONER.VPP";
-    emit request_load(QString::fromStdString(summoner_path));
+    return &atlases_.emplace(item->absolute_path, std::move(atlas)).first->second;
+}
 
-    auto peg_name = QString::fromStdString(item->name).contains("pal") ? summoner_path + "/start0-keep-pal.peg" : summoner_path + "/start0-keep.peg";
-    auto *peg = vfs_->get_entry(peg_name);
+bool Vf2Viewer::load_texture(const VfsEntry *item, FontAtlas &atlas)
+{
+    /* The glyphs are in a VBM of the same name, in a PEG that both PAL and
+     * NTSC versions have (SUMMONER.VPP in Summoner 2). */
+    const std::string peg_name = item->name.find("pal") != std::string::npos ? "start0-keep-pal.peg" : "start0-keep.peg";
+    auto *peg = vfs_->resolve(peg_name);
     if (!peg) {
         spdlog::error("VF2: Failed to find '{}'", peg_name);
-        return;
+        return false;
     }
 
-    auto images = ace3x::peg::get_images(peg->data);
-
-    auto vbm_name = item->name.substr(0, item->name.size() - 4) + ".vbm";
+    vfs_->load_children(peg);
 
-    ace3x::peg::Image *vbm {nullptr};
-    for (auto &image : images) {
-        if (image.filename == vbm_name) {
-            vbm = &image;
-            break;
-        }
+    const auto vbm_name = item->name.substr(0, item->name.size() - 4) + ".vbm";
+    const auto *vbm = vfs_->get_entry(peg->absolute_path + '/' + vbm_name);
+    if (!vbm) {
+        spdlog::error("VF2: Failed to find '{}/{}'", peg->relative_path, vbm_name);
+        return false;
     }
 
-    if (!vbm) {
-        spdlog::error("VF2: Failed to find '{}/{}'", peg_name, vbm_name);
-        return;
+    /* Only this frame is decoded, not the rest of the PEG. */
+    const auto image = ace3x::peg::get_image(peg->data, peg->size, vbm->index);
+    if (image.pixels.empty()) {
+        spdlog::error("VF2: Failed to decode '{}/{}'", peg->relative_path, vbm_name);
+        return false;
     }
 
-    auto img = QImage(reinterpret_cast<const unsigned char *>(vbm->pixels.data()), vbm->width, vbm->height, QImage::Format_ARGB32);
-    font_pixmap_->convertFromImage(img);
-    ui_->image_label->setPixmap(*font_pixmap_);
+    /* Premultiplied is what QPainter blends fastest. Converting also copies
+     * the pixels out of image, which is about to go away. */
+    atlas.image = QImage(reinterpret_cast<const unsigned char *>(image.pixels.data()), image.width, image.height, QImage::Format_ARGB32).convertToFormat(QImage::Format_ARGB32_Premultiplied);
 
+    /* Glyphs are packed in rows of the font's height, in character order. */
+    const int tex_h = static_cast<int>(atlas.font.header.height);
     int tex_x = 0;
     int tex_y = 0;
-    int tex_w = 0;
-    int tex_h = font_height_;
 
-    char_rects_.resize(chars.size());
+    atlas.glyph_rects.reserve(atlas.font.chars.size());
 
-    for (auto i = 0u; i < chars.size(); i++) {
-        tex_w = chars[i].max_width;
-        if (tex_x + tex_w >= img.width()) {
+    for (const auto &c : atlas.font.chars) {
+        const int tex_w = static_cast<int>(c.width);
+        if (tex_x + tex_w >= image.width) {
             tex_x = 0;
             tex_y += tex_h;
         }
-        char_rects_[i] = {tex_x, tex_y, tex_w, tex_h};
+        atlas.glyph_rects.emplace_back(tex_x, tex_y, tex_w, tex_h);
         tex_x += tex_w;
     }
 
-    ui_->plainTextEdit->clear();
-    ui_->tab_2->setEnabled(true);
-}
-
-bool Vf2Viewer::shouldBeEnabled(const VfsEntry *) const
-{
     return true;
 }
 
 void Vf2Viewer::update_font_scene()
 {
-    font_scene_->clear();
+    if (!atlas_ || atlas_->glyph_rects.empty()) {
+        placed_.clear();
+        preview_item_->setPixmap(QPixmap());
+        return;
+    }
 
     const auto text = ui_->plainTextEdit->toPlainText();
+    const auto extent = ace3x::vf2::layout(atlas_->font, atlas_->kerning, text.utf16(), static_cast<std::size_t>(text.size()), placed_);
 
-    int draw_x = 0;
-    int draw_y = 0;
-
-    for (auto i = 0; i < text.size(); i++) {
-        if (text[i] == '\n') {
-            draw_x = 0;
-            draw_y += font_height_;
-            continue;
-        }
+    /* The scene spans the whole text so it scrolls as usual, but only what is
+     * in view gets drawn. */
+    font_scene_->setSceneRect(0, 0, std::max(extent.width, 1), std::max(extent.height, 1));
 
-        if (text[i] == ' ') {
-            /* This looks weird, but as 'space' happens to be the first character
-            * in the vector, it works. */
-            draw_x += char_rects_[' '].width();
-            continue;
-        }
+    draw_visible_glyphs();
+}
 
-        auto val = text[i].unicode() - first_ascii_;
+void Vf2Viewer::draw_visible_glyphs()
+{
+    if (!atlas_ || placed_.empty()) {
+        preview_item_->setPixmap(QPixmap());
+        return;
+    }
 
-        if (val >= char_rects_.size())
-            continue;
+    const auto *view = ui_->graphicsView;
+    const QRect visible = view->mapToScene(view->viewport()->rect()).boundingRect().toAlignedRect().intersected(font_scene_->sceneRect().toAlignedRect());
 
-        const auto &char_rect = char_rects_[val];
+    if (visible.isEmpty()) {
+        preview_item_->setPixmap(QPixmap());
+        return;
+    }
 
-        auto *item = font_scene_->addPixmap(font_pixmap_->copy(char_rect));
-        item->setPos(draw_x, draw_y);
+    /* At most the size of the viewport. Grown to fit and kept while typing,
+     * but given back once the view is much smaller than the largest it has
+     * been. */
+    const auto area = [](const QSize &s) { return static_cast<qint64>(s.width()) * s.height(); };
+    if (preview_.width() < visible.width() || preview_.height() < visible.height()) {
+        preview_ = QImage(visible.size().expandedTo(preview_.size()), QImage::Format_ARGB32_Premultiplied);
+    }
+    else if (area(preview_.size()) > 4 * area(visible.size())) {
+        preview_ = QImage(visible.size(), QImage::Format_ARGB32_Premultiplied);
+    }
 
-        draw_x += char_rect.width();
+    const QRect used(QPoint(), visible.size());
+
+    {
+        QPainter painter(&preview_);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(used, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.setClipRect(used);
+        painter.translate(-visible.topLeft());
+
+        for (const auto &glyph : placed_) {
+            const auto &source = atlas_->glyph_rects[glyph.index];
+            if (visible.intersects(QRect(glyph.x, glyph.y, source.width(), source.height()))) {
+                painter.drawImage(QPoint(glyph.x, glyph.y), atlas_->image, source);
+            }
+        }
     }
+
+    /* Only the used part is copied out, and the copy is moved into the pixmap. */
+    preview_item_->setPixmap(QPixmap::fromImage(preview_.copy(used)));
+    preview_item_->setPos(visible.topLeft());
 }
@@ -3,12 +3,19 @@
 #ifndef ACE3X_WIDGETS_FORMAT_VIEWERS_VF2_VIEWER_HPP_
 #define ACE3X_WIDGETS_FORMAT_VIEWERS_VF2_VIEWER_HPP_
 
+#include <QImage>
 #include <QWidget>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "format-readers/vf2.hpp"
 #include "widgets/format-viewers/viewer.hpp"
 
+class QGraphicsPixmapItem;
 class QGraphicsScene;
+class QTimer;
 
 namespace Ui {
 class Vf2Viewer;
@@ -23,31 +30,43 @@ public:
 
     void activate(const VfsEntry *item) override;
     bool shouldBeEnabled(const VfsEntry *item) const override;
+    void clear() override;
 
-signals:
-    void request_load(const QString &path);
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
     void update_font_scene();
+    void draw_visible_glyphs();
+
+private:
+    /* A parsed font, its kerning and its decoded VBM, built once and kept
+     * until the VFS is cleared. */
+    struct FontAtlas {
+        ace3x::vf2::Font font;
+        ace3x::vf2::KerningTable kerning;
+        QImage image;
+        /* Where each character is in image, indexed like Font::chars. */
+        std::vector<QRect> glyph_rects;
+    };
+
+    const FontAtlas *load_atlas(const VfsEntry *item);
+    bool load_texture(const VfsEntry *item, FontAtlas &atlas);
 
 private:
     std::unique_ptr<Ui::Vf2Viewer> ui_;
     Vfs *vfs_;
     QGraphicsScene *font_scene_;
+    QGraphicsPixmapItem *preview_item_;
+    QTimer *preview_timer_;
 
-    struct FontChar {
-        int min_width;
-        int max_width;
-        std::uint32_t pixel_offset;
-        std::uint32_t kerning_back_pixels_width;
-    };
-
-    int font_height_;
-    int first_ascii_;
-
-    std::vector<QRect> char_rects_;
+    /* Reused by every update, so typing doesn't allocate. The preview only
+     * covers the part of the laid out text in view. */
+    QImage preview_;
+    std::vector<ace3x::vf2::PlacedGlyph> placed_;
 
-    std::unique_ptr<QPixmap> font_pixmap_;
+    std::unordered_map<std::string, FontAtlas> atlases_;
+    const FontAtlas *atlas_ {nullptr};
 };
 
 #endif    // ACE3X_WIDGETS_FORMAT_VIEWERS_VF2_VIEWER_HPP_
@@ -4,3 +4,7 @@ Viewer::Viewer(QWidget *parent)
     : QWidget(parent)
 {
 }
+
+void Viewer::clear()
+{
+}
@@ -17,6 +17,9 @@ public:
     virtual void activate(const VfsEntry *item) = 0;
     virtual bool shouldBeEnabled(const VfsEntry *item) const = 0;
 
+    /* Drops any references into the VFS. Called before it is cleared. */
+    virtual void clear();
+
 signals:
     void referenced_file(const std::string &filename);
 };
@@ -4,32 +4,28 @@
 
 #include <spdlog/spdlog.h>
 
+#include "format-readers/validation-error.hpp"
 #include "formats/vim.hpp"
 #include "ui_vim-viewer.h"
 #include "vfs/vfs-entry.hpp"
+#include "widgets/mesh-canvas.hpp"
+#include "widgets/struct-table-model.hpp"
 
-float ieee_float(uint32_t f)
-{
-    static_assert(sizeof(float) == sizeof f, "`float` has a weird size.");
-    float ret;
-    std::memcpy(&ret, &f, sizeof(float));
-    return ret;
-}
+namespace {
 
-QTableWidgetItem *uintItem(std::uint32_t n, int base)
+/* Fills model with table, behind a column of the offset of each row. */
+template <typename T>
+void show_table(StructTableModel *model, QLabel *count, const char *label, const ace3x::Table<T> &table)
 {
-    return new QTableWidgetItem(QString::number(n, base));
-}
+    model->set_table(table);
+    model->insert_column(0, "VIM offset", StructTableModel::Display::Hex, [table](std::uint32_t row) {
+        return table.offset_of(row);
+    });
 
-QTableWidgetItem *floatItem(std::uint32_t n)
-{
-    return new QTableWidgetItem(QString::number(ieee_float(n), 'G', 4));
+    count->setText(QString("%1 # %2").arg(label).arg(table.size()));
 }
 
-QTableWidgetItem *floatItem(float n)
-{
-    return new QTableWidgetItem(QString::number(n, 'G', 4));
-}
+}    // namespace
 
 VIMViewer::VIMViewer(QWidget *parent)
     : Viewer(parent)
@@ -37,7 +33,22 @@ VIMViewer::VIMViewer(QWidget *parent)
 {
     ui_->setupUi(this);
 
-    connect(ui_->sub0List, &QTableWidget::itemSelectionChanged, this, &VIMViewer::sub0Changed);
+    canvas_ = new MeshCanvas(this);
+    ui_->gridLayout_3->addWidget(canvas_, 7, 0);
+
+    sub0_model_ = new StructTableModel(this);
+    sub1_model_ = new StructTableModel(this);
+    sub2_model_ = new StructTableModel(this);
+    bone_model_ = new StructTableModel(this);
+    sub4_model_ = new StructTableModel(this);
+    sub5_model_ = new StructTableModel(this);
+
+    ui_->sub0List->setModel(sub0_model_);
+    ui_->sub1List->setModel(sub1_model_);
+    ui_->sub2List->setModel(sub2_model_);
+    ui_->vifBoneList->setModel(bone_model_);
+    ui_->sub4List->setModel(sub4_model_);
+    ui_->sub5List->setModel(sub5_model_);
 
     ui_->sub0List->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
     ui_->sub1List->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
@@ -45,145 +56,42 @@ VIMViewer::VIMViewer(QWidget *parent)
     ui_->vifBoneList->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
     ui_->sub4List->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
     ui_->sub5List->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
+
+    connect(ui_->sub0List->selectionModel(), &QItemSelectionModel::currentRowChanged, this, &VIMViewer::sub0Changed);
 }
 
 void VIMViewer::activate(const VfsEntry *item)
 {
-    item_ = item;
+    clear();
 
-    ui_->texList->clear();
-
-    ui_->sub0List->clear();
-    ui_->sub1List->clear();
-    ui_->sub2List->clear();
-    ui_->vifBoneList->clear();
-    ui_->sub4List->clear();
-    ui_->sub5List->clear();
-
-    ui_->sub0Count->clear();
-    ui_->sub1Count->clear();
-    ui_->sub2Count->clear();
-    ui_->vifBoneCount->clear();
-    ui_->sub4Count->clear();
-    ui_->sub5Count->clear();
+    item_ = item;
 
     show();
 
-    vim_.read(item->data);
-
-    ui_->texCount->setText(QString::number(vim_.numTextures_0x1c_));
-    for (std::uint32_t i = 0u; i < vim_.numTextures_0x1c_; i++)
-        ui_->texList->addItem(vim_.textureNames_0x20_[i]);
-
-    if (vim_.sub0_count_ > 10000) {
-        spdlog::warn("VIM: Something went wrong");
+    try {
+        vim_ = ace3x::vim::read(item->data, item->size, item->name);
+    }
+    catch (const ValidationError &e) {
+        spdlog::warn("{}", e.what());
         return;
     }
 
-    ui_->sub0Count->setText(QString("Sub0 # %1").arg(vim_.sub0_count_));
-    ui_->sub0List->setRowCount(vim_.sub0_count_);
-    ui_->sub0List->setColumnCount(1);
-    ui_->sub0List->setHorizontalHeaderLabels({"VIM offset"});
-
-    for (std::uint32_t i = 0u; i < vim_.sub0_count_; i++) {
-        std::uint32_t offset = vim_.sub0_data_ + sizeof(VifMeshSub0) * i;
-        ui_->sub0List->setItem(i, 0, uintItem(offset, 16));
+    ui_->texCount->setText(QString::number(vim_.texture_names.size()));
+    for (const auto name : vim_.texture_names) {
+        ui_->texList->addItem(QString::fromLatin1(name.data(), static_cast<int>(name.size())));
     }
 
-    ui_->vifBoneCount->setText(QString("vifBone # %1").arg(vim_.vifBone_count_));
-    ui_->vifBoneList->setRowCount(vim_.vifBone_count_);
-    ui_->vifBoneList->setColumnCount(28 + 2);
-    ui_->vifBoneList->setHorizontalHeaderLabels({"VIM offset", "Name offset", "Name", "x", "y", "z"});
-
-    for (std::uint32_t row = 0u; row < vim_.vifBone_count_; row++) {
-        std::uint32_t offset = vim_.vifBone_data_ + sizeof(VifBone) * row;
-        auto *ptr = &item_->data[offset];
-
-        VifBone vifBone;
-        std::memcpy(&vifBone, ptr, sizeof(VifBone));
-
-        ui_->vifBoneList->setItem(row, 0, uintItem(offset, 16));    // extra
-        ui_->vifBoneList->setItem(row, 1, uintItem(vifBone.boneNameOff, 16));
-        ui_->vifBoneList->setItem(row, 3, floatItem(vifBone.x));
-        ui_->vifBoneList->setItem(row, 4, floatItem(vifBone.y));
-        ui_->vifBoneList->setItem(row, 5, floatItem(vifBone.z));
-        ui_->vifBoneList->setItem(row, 6, floatItem(vifBone.a));
-        ui_->vifBoneList->setItem(row, 7, floatItem(vifBone.b));
-        ui_->vifBoneList->setItem(row, 8, floatItem(vifBone.c));
-
-        if (vifBone.boneNameOff >= item_->size) {
-            spdlog::warn("VIM: Something went wrong");
-            return;
-        }
-
-        QString name;
-        ptr = item_->data + vifBone.boneNameOff;
-        while (*ptr != 0x0)
-            name += *ptr++;
-
-        ui_->vifBoneList->setItem(row, 2, new QTableWidgetItem(name));    // extra
-
-        for (int column = 7; column < 28; column++) {
-            uint32_t *off = reinterpret_cast<uint32_t *>(&vifBone) + column;
-            ui_->vifBoneList->setItem(row, column + 2, floatItem(*off));
-        }
-    }
+    show_bones();
 
-    ui_->sub4Count->setText(QString("Sub4 # %1").arg(vim_.sub4_count_));
-    ui_->sub4List->setRowCount(vim_.sub4_count_);
-    ui_->sub4List->setColumnCount(15);
-    ui_->sub4List->setHorizontalHeaderLabels({"VIM offset"});
-
-    for (std::uint32_t row = 0u; row < vim_.sub4_count_; row++) {
-        std::uint32_t offset = vim_.sub4_data_ + (sizeof(VifMeshSub4) * row);
-
-        VifMeshSub4 sub4;
-        std::memcpy(&sub4, &item_->data[offset], sizeof(VifMeshSub4));
-
-        ui_->sub4List->setItem(row, 0, uintItem(offset, 16));
-
-        for (int column = 0; column < 14; column++) {
-            uint32_t *off = reinterpret_cast<uint32_t *>(&sub4) + column;
-            if (column == 0) {
-                auto str = QString::number(*off, 16);
-                ui_->sub4List->setItem(row, column + 1, new QTableWidgetItem(str));
-            }
-            else {
-                auto str = QString::number(ieee_float(*off), 'G', 4);
-                ui_->sub4List->setItem(row, column + 1, new QTableWidgetItem(str));
-            }
-        }
-    }
+    show_table(sub0_model_, ui_->sub0Count, "Sub0", vim_.sub0);
+    show_table(bone_model_, ui_->vifBoneCount, "vifBone", vim_.bones);
+    show_table(sub4_model_, ui_->sub4Count, "Sub4", vim_.sub4);
+    show_table(sub5_model_, ui_->sub5Count, "Sub5", vim_.sub5);
 
-    ui_->sub5Count->setText(QString("Sub5 # %1").arg(vim_.sub5_count_));
-    ui_->sub5List->setRowCount(vim_.sub5_count_);
-    ui_->sub5List->setColumnCount(9);
-    ui_->sub5List->setHorizontalHeaderLabels({"VIM offset"});
-
-    for (std::uint32_t row = 0u; row < vim_.sub5_count_; row++) {
-        std::uint32_t offset = vim_.sub5_data_ + (sizeof(VifMeshSub5) * row);
-
-        ui_->sub5List->setItem(row, 0, new QTableWidgetItem(QString::number(offset, 16)));
-
-        VifMeshSub5 sub5;
-        std::memcpy(&sub5, &item_->data[offset], sizeof(VifMeshSub5));
-
-        for (int column = 0; column < 8; column++) {
-            std::uint32_t *off = reinterpret_cast<uint32_t *>(&sub5) + column;
-            //            if (column == 0)
-            {
-                auto value = *off;
-                auto str = QString("0x%1").arg(value);
-                ui_->sub5List->setItem(row, column + 1, new QTableWidgetItem(str));
-            }
-            //            else
-            {
-                //                auto value = ieee_float(*off);
-                //                auto str = QString("%1").arg(value);
-                //                ui_->sub4List->setItem(row, column, new QTableWidgetItem(str));
-            }
-        }
-    }
+    bone_model_->insert_column(2, "Name", StructTableModel::Display::Text, [this](std::uint32_t row) {
+        const auto name = vim_.string_at(vim_.bones[row].boneNameOff);
+        return QString::fromLatin1(name.data(), static_cast<int>(name.size()));
+    });
 }
 
 bool VIMViewer::shouldBeEnabled(const VfsEntry *) const
@@ -191,55 +99,60 @@ bool VIMViewer::shouldBeEnabled(const VfsEntry *) const
     return true;
 }
 
-void VIMViewer::sub0Changed()
+/* The tables and vim_ point into the entry's data. */
+void VIMViewer::clear()
 {
-    /*
-    VifMeshSub0 sub0;
-    std::memcpy(&sub0, &item_->getData()[vim_.sub0_data_ + (sizeof(VifMeshSub0) * ui_->sub0List->currentRow())], sizeof(VifMeshSub0));
-
-    ui_->sub1Count->setText(QString("Sub1 # %1").arg(sub0.sub1_count));
-    ui_->sub1List->setRowCount(sub0.sub1_count);
-    ui_->sub1List->setColumnCount(14);
-    ui_->sub1List->setHorizontalHeaderLabels({"VIM offset", "?", "?", "?", "?", "Mesh #", "Offset0", "Offset1", "?", "Offset2", "Offset3", "Offset4", "Offset5", "Offset6"});
-
-    for (std::uint32_t row = 0u; row < sub0.sub1_count; row++) {
-        std::uint32_t offset = sub0.sub1_data + (sizeof(VifMeshSub1) * row);
-
-        VifMeshSub1 sub1;
-        std::memcpy(&sub1, &item_->getData()[offset], sizeof(VifMeshSub1));
-
-        int col = 0;
-        ui_->sub1List->setItem(row, col++, uintItem(offset, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.field_0x0, 10));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.field_0x2, 10));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.field_0x4, 10));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.field_0x6, 10));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.meshIdx, 10));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off0, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off1, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.field_0x14, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off2, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off3, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off4, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off5, 16));
-        ui_->sub1List->setItem(row, col++, uintItem(sub1.off6, 16));
+    ui_->texList->clear();
+    ui_->texCount->clear();
+
+    for (auto *model : {sub0_model_, sub1_model_, sub2_model_, bone_model_, sub4_model_, sub5_model_}) {
+        model->clear();
+    }
+
+    for (auto *count : {ui_->sub0Count, ui_->sub1Count, ui_->sub2Count, ui_->vifBoneCount, ui_->sub4Count, ui_->sub5Count}) {
+        count->clear();
     }
 
-    ui_->sub2Count->setText(QString("Sub2 # %1").arg(sub0.sub2_count));
-    ui_->sub2List->setRowCount(sub0.sub2_count);
-    ui_->sub2List->setColumnCount(4);
-    ui_->sub2List->setHorizontalHeaderLabels({"VIM offset", "Offset1"});
+    vim_ = {};
+    item_ = nullptr;
+    canvas_->clear();
+}
 
-    for (std::uint32_t row = 0u; row < sub0.sub2_count; row++) {
-        std::uint32_t offset = sub0.sub2_data + (sizeof(VifMeshSub2) * row);
+void VIMViewer::show_bones()
+{
+    /* How the bones connect is not known yet, so each one is a point. */
+    ace3x::p3d::Geometry geometry;
+    geometry.positions.reserve(vim_.bones.size() * 3);
+
+    for (std::uint32_t i = 0u; i < vim_.bones.size(); i++) {
+        const VifBone vifBone = vim_.bones[i];
+        geometry.positions.insert(geometry.positions.end(), {vifBone.x, vifBone.y, vifBone.z});
+    }
 
-        VifMeshSub2 sub2;
-        std::memcpy(&sub2, &item_->getData()[offset], sizeof(VifMeshSub2));
+    ace3x::p3d::MeshRange bones;
+    bones.name = "bones";
+    bones.num_vertices = vim_.bones.size();
+    geometry.meshes.push_back(std::move(bones));
 
-        ui_->sub2List->setItem(row, 0, uintItem(offset, 16));
-        ui_->sub2List->setItem(row, 1, uintItem(sub2.off0, 16));
-        ui_->sub2List->setItem(row, 2, uintItem(sub2.field_0x4, 16));
-        ui_->sub2List->setItem(row, 3, uintItem(sub2.field_0x6, 16));
+    canvas_->set_geometry(std::move(geometry));
+}
+
+void VIMViewer::sub0Changed()
+{
+    const int current = ui_->sub0List->currentIndex().row();
+    if (current < 0 || static_cast<std::uint32_t>(current) >= vim_.sub0.size()) {
+        return;
+    }
+
+    const VifMeshSub0 sub0 = vim_.sub0[current];
+
+    try {
+        show_table(sub1_model_, ui_->sub1Count, "Sub1", vim_.sub1(sub0));
+        show_table(sub2_model_, ui_->sub2Count, "Sub2", vim_.sub2(sub0));
+    }
+    catch (const ValidationError &e) {
+        spdlog::warn("{}", e.what());
+        sub1_model_->clear();
+        sub2_model_->clear();
     }
-    */
 }
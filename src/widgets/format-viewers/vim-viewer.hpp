@@ -15,6 +15,9 @@ namespace Ui {
 class VIMViewer;
 }
 
+class MeshCanvas;
+class StructTableModel;
+
 class VIMViewer : public Viewer {
     Q_OBJECT
 public:
@@ -22,11 +25,22 @@ public:
 
     void activate(const VfsEntry *item) override;
     bool shouldBeEnabled(const VfsEntry *item) const override;
+    void clear() override;
+
+private:
+    void show_bones();
 
 private:
     std::unique_ptr<Ui::VIMViewer> ui_;
-    VifMesh vim_;
-    const VfsEntry *item_;
+    MeshCanvas *canvas_;
+    StructTableModel *sub0_model_;
+    StructTableModel *sub1_model_;
+    StructTableModel *sub2_model_;
+    StructTableModel *bone_model_;
+    StructTableModel *sub4_model_;
+    StructTableModel *sub5_model_;
+    ace3x::vim::Mesh vim_;
+    const VfsEntry *item_ {nullptr};
 
 private slots:
     void sub0Changed();
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "widgets/frame-canvas.hpp"
+
+#include <QPainter>
+
+FrameCanvas::FrameCanvas(QWidget *parent)
+    : QFrame(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void FrameCanvas::set_frame(const std::uint32_t *pixels, int width, int height)
+{
+    /* Wraps the buffer, no copy. */
+    image_ = QImage(reinterpret_cast<const uchar *>(pixels), width, height, QImage::Format_ARGB32);
+    setMinimumSize(image_.size());
+    updateGeometry();
+    update();
+}
+
+void FrameCanvas::clear()
+{
+    image_ = QImage();
+    update();
+}
+
+void FrameCanvas::set_background(const QColor &colour)
+{
+    background_ = colour;
+    update();
+}
+
+QSize FrameCanvas::sizeHint() const
+{
+    return image_.isNull() ? QFrame::sizeHint() : image_.size();
+}
+
+void FrameCanvas::paintEvent(QPaintEvent *event)
+{
+    {
+        QPainter painter(this);
+        painter.fillRect(rect(), background_);
+
+        if (!image_.isNull()) {
+            const auto origin = rect().center() - QPoint(image_.width() / 2, image_.height() / 2);
+            painter.drawImage(origin, image_);
+        }
+    }
+
+    QFrame::paintEvent(event);
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_WIDGETS_FRAME_CANVAS_HPP_
+#define ACE3X_WIDGETS_FRAME_CANVAS_HPP_
+
+#include <QColor>
+#include <QFrame>
+#include <QImage>
+#include <cstdint>
+
+/* Paints an ARGB32 frame straight from a caller-owned buffer, without going
+ * through a QPixmap. The buffer must outlive the frame or the next set_frame. */
+class FrameCanvas : public QFrame {
+    Q_OBJECT
+
+public:
+    explicit FrameCanvas(QWidget *parent = nullptr);
+
+    void set_frame(const std::uint32_t *pixels, int width, int height);
+    void clear();
+    void set_background(const QColor &colour);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QImage image_;
+    QColor background_;
+};
+
+#endif    // ACE3X_WIDGETS_FRAME_CANVAS_HPP_
@@ -15,19 +15,34 @@
 #include <QSplitter>
 #include <QTextEdit>
 #include <QTextStream>
+#include <QTimer>
 #include <QTreeView>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
 
+#include "batch/archives.hpp"
+#include "startup-trace.hpp"
 #include "tree-model/sort-proxy.hpp"
 #include "tree-model/tree-model.hpp"
 #include "ui_main-window.h"
 #include "vfs/mmap-vfs.hpp"
+#include "vfs/vfs-entry.hpp"
 #include "widgets/file-info-frame.hpp"
 #include "widgets/format-viewers/image-viewer.hpp"
 #include "widgets/format-viewers/p3d-viewer.hpp"
 #include "widgets/format-viewers/plaintext-viewer.hpp"
+#include "widgets/format-viewers/thumbnail-viewer.hpp"
 #include "widgets/format-viewers/vf2-viewer.hpp"
 #include "widgets/format-viewers/vim-viewer.hpp"
 
+namespace {
+
+/* The session, which also holds the settings. */
+constexpr const char *kSettingsPath {"settings.txt"};
+
+}    // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui_MainWindow())
@@ -46,20 +61,46 @@ MainWindow::MainWindow(QWidget *parent)
     tree_sort_proxy_->setSourceModel(tree_model_);
     ui->tree_view->setModel(tree_sort_proxy_);
 
-    auto *image_viewer {new ImageViewer()};
-    auto *text_viewer {new PlaintextViewer()};
-    auto *vf2_viewer {new Vf2Viewer(vfs_.get())};
-    ui->view_manager->add_viewer(".peg", image_viewer);
-    ui->view_manager->add_viewer(".tga", image_viewer);
-    ui->view_manager->add_viewer(".vbm", image_viewer);
-    ui->view_manager->add_viewer(".tbl", text_viewer);
-    ui->view_manager->add_viewer(".arr", text_viewer);
-    ui->view_manager->add_viewer(".vim", new VIMViewer());
-    ui->view_manager->add_viewer(".p3d", new P3DViewer());
-    ui->view_manager->add_viewer(".vf2", vf2_viewer);
+    ace3x::startup::mark("Main window: setupUi");
+
+    /* Viewers are built on first use, most sessions only need one or two. */
+    auto *vfs = vfs_.get();
+    ui->inspector->set_vfs(vfs);
+    ui->view_manager->add_viewer({ace3x::FormatId::Peg, ace3x::FormatId::Tga, ace3x::FormatId::Vbm}, [] { return new ImageViewer(); });
+    ui->view_manager->add_viewer({ace3x::FormatId::Tbl, ace3x::FormatId::Arr}, [] { return new PlaintextViewer(); });
+    ui->view_manager->add_viewer({ace3x::FormatId::Vim}, [] { return new VIMViewer(); });
+    ui->view_manager->add_viewer({ace3x::FormatId::P3d}, [] { return new P3DViewer(); });
+    ui->view_manager->add_viewer({ace3x::FormatId::Vf2}, [vfs] { return new Vf2Viewer(vfs); });
+    ui->view_manager->add_viewer({ace3x::FormatId::Vpp}, [vfs] { return new ThumbnailViewer(vfs); });
 
     load_settings();
 
+    ace3x::startup::mark("Main window: settings");
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &MainWindow::save_session);
+
+    /* Archives loaded to resolve a reference are shown like any other. */
+    vfs_->set_archive_loaded_callback([this](VfsEntry *archive) {
+        tree_model_->addTopLevelEntry(archive);
+        ui->tree_view->resizeColumnToContents(0);
+    });
+
+    /* Containers are listed in the background so searches find their entries.
+     * The callback runs on the indexing thread. */
+    vfs_->set_indexed_callback([this]() {
+        QMetaObject::invokeMethod(this, "add_indexed_children", Qt::QueuedConnection);
+    });
+
+    /* Browsing touches a few scattered entries, reading ahead only wastes IO. */
+    vfs_->set_access_pattern(AccessPattern::Random);
+
+    /* Wait for a pause in typing rather than searching on every keystroke. */
+    search_timer_ = new QTimer(this);
+    search_timer_->setSingleShot(true);
+    search_timer_->setInterval(150);
+    connect(ui->search, &QLineEdit::textChanged, search_timer_, QOverload<>::of(&QTimer::start));
+    connect(search_timer_, &QTimer::timeout, this, &MainWindow::apply_search);
+
     connect(ui->action_open, &QAction::triggered, this, &MainWindow::action_open);
     connect(ui->action_close, &QAction::triggered, this, &MainWindow::action_close);
     connect(ui->action_quit, &QAction::triggered, this, &MainWindow::action_quit);
@@ -69,19 +110,24 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->tree_view, &QTreeView::expanded, this, [this]() {
         ui->tree_view->resizeColumnToContents(0);
     });
-    connect(ui->inspector, &FileInfoFrame::view_clicked, this, [this]() {
+    /* Connected first, so a container is listed before its viewer is activated. */
+    connect(ui->inspector, &FileInfoFrame::view_clicked, this, [this](VfsEntry *entry) {
         ui->referenced_files->clear();
+        vfs_->load_children(entry);
     });
     connect(ui->inspector, &FileInfoFrame::view_clicked, ui->view_manager, &ViewManager::activate_viewer);
     connect(ui->clear_log_btn, &QPushButton::clicked, this, [this]() {
         ui->log->clear();
     });
-    connect(vf2_viewer, &Vf2Viewer::request_load, this, &MainWindow::load_extra);
+    connect(ui->referenced_files, &QListWidget::itemClicked, this, &MainWindow::show_referenced_file);
     connect(ui->view_manager, &ViewManager::referenced_file, this, &MainWindow::add_referenced_file);
+
+    ace3x::startup::mark("Main window: connections");
 }
 
 MainWindow::~MainWindow()
 {
+    vfs_->set_indexed_callback(nullptr);
     delete tree_model_;
     delete tree_sort_proxy_;
     delete ui;
@@ -100,9 +146,12 @@ void MainWindow::update_selection(const QItemSelection &selected, const QItemSel
 
     auto *entry = tree_model_->itemFromIndex(tree_sort_proxy_->mapToSource(selected.indexes().first()));
 
+    /* Likely to be viewed next, so start reading it while the inspector updates. */
+    vfs_->prefetch(entry);
+
     ui->inspector->set_item(entry);
 
-    if (ui->view_manager->has_viewer(entry->extension)) {
+    if (ui->view_manager->has_viewer(entry_format(entry))) {
         ui->inspector->enable_view();
     }
 }
@@ -114,6 +163,8 @@ void MainWindow::action_open()
 
 void MainWindow::action_close()
 {
+    /* The matches point into the VFS; the query itself is kept for the next load. */
+    tree_sort_proxy_->clear_matches();
     tree_model_->clear();
     ui->inspector->clear();
     ui->view_manager->clear();
@@ -123,28 +174,64 @@ void MainWindow::action_close()
 
 void MainWindow::action_quit()
 {
-    QFile file("settings.txt");
-    if (file.open(QIODevice::ReadWrite)) {
-        QTextStream stream(&file);
-        stream << last_open_path_ << endl;
-    }
-    file.close();
-
     spdlog::debug("Shutting down");
 
+    /* The session is saved on aboutToQuit, however the app quits. */
     QApplication::quit();
 }
 
 void MainWindow::load(const QString &path)
 {
-    if (path.isEmpty())
+    load(QStringList {path});
+}
+
+void MainWindow::load(const QStringList &paths)
+{
+    if (std::all_of(paths.begin(), paths.end(), [](const QString &path) { return path.isEmpty(); })) {
         return;
+    }
 
     action_close();
 
-    last_open_path_ = QFileInfo(path).dir().absolutePath();
+    int num_loaded = 0;
 
-    int num_loaded = tree_model_->load(path, vfs_.get());
+    /* One missing or broken archive, such as one from a restored session
+     * that was deleted since, is skipped rather than ending the load. */
+    const auto load_archive = [&](const QString &path) {
+        try {
+            num_loaded += tree_model_->load(path, vfs_.get());
+        }
+        catch (const std::exception &e) {
+            spdlog::error("Main window: Skipping '{}': {}", path.toStdString(), e.what());
+        }
+    };
+
+    for (const auto &path : paths) {
+        if (path.isEmpty()) {
+            continue;
+        }
+
+        const QFileInfo info(path);
+        if (!info.exists()) {
+            spdlog::warn("Main window: Skipping '{}', which no longer exists", path.toStdString());
+            continue;
+        }
+
+        /* LEVELS directories are handled by the tree, which only opens the level archives. */
+        if (info.isDir() && !path.contains("LEVELS")) {
+            for (const auto &archive : ace3x::batch::find_archives({path.toStdString()})) {
+                load_archive(QString::fromStdString(archive));
+            }
+        }
+        else {
+            load_archive(path);
+        }
+
+        last_open_path_ = info.isDir() ? info.absoluteFilePath() : info.dir().absolutePath();
+
+        /* References into other archives of the game are loaded from here. */
+        vfs_->add_search_directory(last_open_path_.toStdString());
+    }
 
     /* If there is only one top-level archive, expand it.
      * Don't do this for multiple top-level archives because it's messy.
@@ -157,35 +244,118 @@ void MainWindow::load(const QString &path)
     ui->tree_view->resizeColumnToContents(0);
 
     ui->action_close->setEnabled(true);
+
+    apply_search();
 }
 
-void MainWindow::load_extra(const QString &path)
+void MainWindow::restore_session()
 {
-    if (path.isEmpty())
+    if (session_.archives.empty()) {
         return;
+    }
+
+    const auto last_open_path = last_open_path_;
+
+    QStringList archives;
+    for (const auto &archive : session_.archives) {
+        archives.push_back(QString::fromStdString(archive));
+    }
+    load(archives);
+
+    last_open_path_ = last_open_path;
+
+    ui->tree_view->collapseAll();
 
-    tree_model_->load(path, vfs_.get());
+    /* Listing containers to find saved nodes reads the archives, which may
+     * have changed since. */
+    try {
+        for (const auto &path : session_.expanded) {
+            if (auto *entry = find_entry(path)) {
+                ui->tree_view->setExpanded(tree_sort_proxy_->mapFromSource(tree_model_->indexFromItem(entry)), true);
+            }
+        }
+
+        if (auto *entry = find_entry(session_.selected)) {
+            const auto index = tree_sort_proxy_->mapFromSource(tree_model_->indexFromItem(entry));
+            ui->tree_view->scrollTo(index);
+            ui->tree_view->setCurrentIndex(index);
+        }
+    }
+    catch (const std::exception &e) {
+        spdlog::error("Session: Failed to restore the expanded and selected nodes: {}", e.what());
+    }
 
     ui->tree_view->resizeColumnToContents(0);
 
-    ui->action_close->setEnabled(true);
+    spdlog::info("Session: Restored {} archives, {} expanded nodes", tree_model_->top_level_entries().size(), session_.expanded.size());
 }
 
-void MainWindow::load_settings()
+VfsEntry *MainWindow::find_entry(const std::string &absolute_path)
 {
-    if (std::filesystem::exists("settings.txt")) {
-        QFile file("settings.txt");
-        if (file.open(QIODevice::ReadOnly)) {
-            QTextStream stream(&file);
-            stream >> last_open_path_;
-            spdlog::info("Loaded settings.txt");
-            spdlog::info("Recently opened path: {}", last_open_path_.toStdString());
+    if (absolute_path.empty()) {
+        return nullptr;
+    }
+
+    if (auto *entry = vfs_->get_entry(absolute_path)) {
+        return entry;
+    }
+
+    /* Children of containers are only in the VFS once listed. */
+    const auto slash = absolute_path.rfind('/');
+    if (slash == std::string::npos) {
+        return nullptr;
+    }
+
+    auto *parent = find_entry(absolute_path.substr(0, slash));
+    if (!parent) {
+        return nullptr;
+    }
+
+    vfs_->load_children(parent);
+
+    return vfs_->get_entry(absolute_path);
+}
+
+void MainWindow::save_session()
+{
+    ace3x::Session session;
+    session.last_open_path = last_open_path_.toStdString();
+
+    /* Only expanded nodes are walked, so a large install costs little. */
+    const std::function<void(const QModelIndex &)> save_expanded = [&](const QModelIndex &parent) {
+        for (int row = 0; row < tree_sort_proxy_->rowCount(parent); row++) {
+            const auto index = tree_sort_proxy_->index(row, 0, parent);
+            if (ui->tree_view->isExpanded(index)) {
+                session.expanded.push_back(tree_model_->itemFromIndex(tree_sort_proxy_->mapToSource(index))->absolute_path);
+                save_expanded(index);
+            }
         }
-        file.close();
+    };
+
+    for (const auto *archive : tree_model_->top_level_entries()) {
+        session.archives.push_back(archive->absolute_path);
     }
-    else {
-        spdlog::info("settings.txt not found");
+    save_expanded(QModelIndex());
+
+    if (const auto *entry = tree_model_->itemFromIndex(tree_sort_proxy_->mapToSource(ui->tree_view->currentIndex()))) {
+        session.selected = entry->absolute_path;
+    }
+
+    ace3x::write_session(kSettingsPath, session);
+}
+
+void MainWindow::load_settings()
+{
+    if (!std::filesystem::exists(kSettingsPath)) {
+        spdlog::info("{} not found", kSettingsPath);
+        return;
     }
+
+    session_ = ace3x::read_session(kSettingsPath);
+    last_open_path_ = QString::fromStdString(session_.last_open_path);
+
+    spdlog::info("Loaded {}", kSettingsPath);
+    spdlog::info("Recently opened path: {}", session_.last_open_path);
 }
 
 void MainWindow::action_about()
@@ -200,5 +370,73 @@ void MainWindow::action_about()
 
 void MainWindow::add_referenced_file(const std::string &filename)
 {
-    ui->referenced_files->addItem(new QListWidgetItem(QString::fromStdString(filename)));
+    const auto name = QString::fromStdString(filename);
+
+    if (ui->referenced_files->findItems(name, Qt::MatchFixedString).isEmpty()) {
+        ui->referenced_files->addItem(new QListWidgetItem(name));
+    }
+}
+
+void MainWindow::show_referenced_file(QListWidgetItem *item)
+{
+    auto *entry = vfs_->resolve(item->text().toStdString());
+
+    if (!entry && vfs_->indexing()) {
+        ui->statusbar->showMessage(QString("'%1' was not found yet, archives are still being indexed").arg(item->text()));
+        return;
+    }
+
+    if (!entry) {
+        ui->statusbar->showMessage(QString("'%1' is not in any archive").arg(item->text()));
+        return;
+    }
+
+    const auto index = tree_sort_proxy_->mapFromSource(tree_model_->indexFromItem(entry));
+
+    if (!index.isValid()) {
+        ui->statusbar->showMessage(QString("'%1' is hidden by the search").arg(item->text()));
+        return;
+    }
+
+    ui->tree_view->scrollTo(index);
+    ui->tree_view->setCurrentIndex(index);
+}
+
+void MainWindow::apply_search()
+{
+    const auto query = ui->search->text().trimmed().toStdString();
+
+    if (query.empty()) {
+        tree_sort_proxy_->clear_matches();
+        ui->statusbar->clearMessage();
+        return;
+    }
+
+    const auto matches = vfs_->search(query);
+    tree_sort_proxy_->set_matches(matches);
+
+    /* Expanding thousands of rows is slower than the search itself. */
+    static constexpr std::size_t kMaxExpandedMatches {500};
+    if (matches.size() <= kMaxExpandedMatches) {
+        ui->tree_view->expandAll();
+    }
+
+    if (vfs_->indexing()) {
+        ui->statusbar->showMessage(QString("%1 matches so far, still indexing").arg(matches.size()));
+    }
+    else {
+        ui->statusbar->showMessage(QString("%1 matches").arg(matches.size()));
+    }
+}
+
+void MainWindow::add_indexed_children()
+{
+    const auto added = vfs_->add_indexed_children();
+
+    /* Refresh the matches with the new entries, and drop the "still indexing"
+     * note once done. Not restarted while pending, or a steady stream of
+     * results would hold the search back until indexing ends. */
+    if ((added > 0 || !vfs_->indexing()) && !ui->search->text().trimmed().isEmpty() && !search_timer_->isActive()) {
+        search_timer_->start();
+    }
 }
@@ -5,14 +5,22 @@
 
 #include <QItemSelection>
 #include <QMainWindow>
+#include <QStringList>
+#include <memory>
+#include <string>
 
+#include "session.hpp"
+
+class QListWidgetItem;
 class QTreeView;
 class QPlainTextEdit;
+class QTimer;
 
 class TreeModel;
 class TreeEntrySortProxy;
 
 class Vfs;
+struct VfsEntry;
 
 class Ui_MainWindow;
 
@@ -24,6 +32,10 @@ public:
     ~MainWindow();
 
     void load(const QString &path);
+    /* Opens archives, and every archive in directories, replacing any open. */
+    void load(const QStringList &paths);
+    /* Reopens the archives of the last session and restores its tree. */
+    void restore_session();
     QPlainTextEdit *get_log();
 
 public slots:
@@ -34,11 +46,16 @@ public slots:
 
 private slots:
     void update_selection(const QItemSelection &selected, const QItemSelection &deselected);
-    void load_extra(const QString &path);
     void add_referenced_file(const std::string &filename);
+    void show_referenced_file(QListWidgetItem *item);
+    void apply_search();
+    void add_indexed_children();
 
 private:
     void load_settings();
+    void save_session();
+    /* Finds an entry by absolute path, listing the containers above it. */
+    VfsEntry *find_entry(const std::string &absolute_path);
 
 private:
     Ui_MainWindow *ui;
@@ -46,6 +63,8 @@ private:
     TreeModel *tree_model_ {nullptr};
     TreeEntrySortProxy *tree_sort_proxy_ {nullptr};
     QString last_open_path_;
+    QTimer *search_timer_ {nullptr};
+    ace3x::Session session_;
 };
 
 #endif    // ACE3X_WIDGETS_MAIN_WINDOW_HPP_
@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "widgets/mesh-canvas.hpp"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+constexpr std::uint32_t kBackground {0xFF202020};
+constexpr std::uint32_t kPointColour {0xFFFFE040};
+
+constexpr std::uint32_t kMeshColours[] {
+    0xFF8FB8DE,
+    0xFFC8A882,
+    0xFF9CC89B,
+    0xFFC79BC2,
+    0xFFD8C77A,
+    0xFF8CC7C1,
+    0xFFD09090,
+    0xFFA8A8C8,
+};
+
+constexpr float kFieldOfView {0.9f};
+
+}    // namespace
+
+MeshCanvas::MeshCanvas(QWidget *parent)
+    : QFrame(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(128, 128);
+    setFocusPolicy(Qt::ClickFocus);
+}
+
+void MeshCanvas::set_geometry(ace3x::p3d::Geometry geometry)
+{
+    geometry_ = std::move(geometry);
+
+    mesh_indices_.resize(geometry_.indices.size());
+    batches_.clear();
+
+    std::array<float, 3> min;
+    std::array<float, 3> max;
+    min.fill(std::numeric_limits<float>::max());
+    max.fill(std::numeric_limits<float>::lowest());
+
+    for (std::size_t i = 0; i < geometry_.meshes.size(); i++) {
+        const auto &mesh = geometry_.meshes[i];
+        if (mesh.num_vertices == 0) {
+            continue;
+        }
+
+        ace3x::imaging::DrawBatch batch;
+        batch.positions = &geometry_.positions[mesh.first_vertex * 3];
+        batch.num_vertices = mesh.num_vertices;
+
+        if (mesh.num_indices) {
+            for (std::uint32_t j = mesh.first_index; j < mesh.first_index + mesh.num_indices; j++) {
+                mesh_indices_[j] = geometry_.indices[j] - mesh.first_vertex;
+            }
+            batch.indices = &mesh_indices_[mesh.first_index];
+            batch.num_indices = mesh.num_indices;
+            batch.colour = kMeshColours[i % std::size(kMeshColours)];
+        }
+        else {
+            batch.colour = kPointColour;
+        }
+
+        batches_.push_back(batch);
+
+        for (std::uint32_t v = 0; v < mesh.num_vertices; v++) {
+            for (int c = 0; c < 3; c++) {
+                min[c] = std::min(min[c], batch.positions[v * 3 + c]);
+                max[c] = std::max(max[c], batch.positions[v * 3 + c]);
+            }
+        }
+    }
+
+    /* Frame the whole geometry. */
+    if (!batches_.empty()) {
+        const std::array<float, 3> size {max[0] - min[0], max[1] - min[1], max[2] - min[2]};
+        target_ = {(min[0] + max[0]) / 2, (min[1] + max[1]) / 2, (min[2] + max[2]) / 2};
+        radius_ = std::max(0.5f * std::sqrt(size[0] * size[0] + size[1] * size[1] + size[2] * size[2]), 1e-3f);
+        distance_ = radius_ / std::sin(kFieldOfView / 2);
+    }
+
+    update();
+}
+
+void MeshCanvas::clear()
+{
+    set_geometry({});
+}
+
+QSize MeshCanvas::sizeHint() const
+{
+    return {512, 384};
+}
+
+void MeshCanvas::paintEvent(QPaintEvent *event)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    rasterizer_.resize(width(), height());
+
+    const std::array<float, 3> eye {
+        target_[0] + distance_ * std::cos(pitch_) * std::sin(yaw_),
+        target_[1] + distance_ * std::sin(pitch_),
+        target_[2] + distance_ * std::cos(pitch_) * std::cos(yaw_),
+    };
+
+    /* Keep the whole geometry between the clip planes at any zoom. */
+    const float near = std::max(distance_ - radius_, distance_ * 1e-3f);
+    const float far = distance_ + radius_;
+
+    const auto projection = ace3x::imaging::perspective(kFieldOfView, static_cast<float>(width()) / std::max(height(), 1), near, far);
+    const auto view = ace3x::imaging::look_at(eye, target_, {0.0f, 1.0f, 0.0f});
+
+    rasterizer_.render(batches_, projection * view, kBackground);
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    {
+        QPainter painter(this);
+
+        if (rasterizer_.width() > 0 && rasterizer_.height() > 0) {
+            /* Wraps the buffer, no copy. */
+            const QImage image(reinterpret_cast<const uchar *>(rasterizer_.pixels()),
+                               rasterizer_.width(),
+                               rasterizer_.height(),
+                               rasterizer_.stride() * static_cast<int>(sizeof(std::uint32_t)),
+                               QImage::Format_RGB32);
+            painter.drawImage(0, 0, image);
+        }
+
+        painter.setPen(Qt::lightGray);
+        painter.drawText(rect().adjusted(6, 4, -6, -4),
+                         Qt::AlignTop | Qt::AlignLeft,
+                         QString("%1 triangles, %2 ms").arg(rasterizer_.num_drawn_triangles()).arg(elapsed.count(), 0, 'f', 1));
+    }
+
+    QFrame::paintEvent(event);
+}
+
+void MeshCanvas::mousePressEvent(QMouseEvent *event)
+{
+    last_mouse_ = event->pos();
+}
+
+void MeshCanvas::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton)) {
+        return;
+    }
+
+    const auto delta = event->pos() - last_mouse_;
+    last_mouse_ = event->pos();
+
+    yaw_ -= delta.x() * 0.01f;
+    pitch_ = std::clamp(pitch_ + delta.y() * 0.01f, -1.55f, 1.55f);
+    update();
+}
+
+void MeshCanvas::wheelEvent(QWheelEvent *event)
+{
+    /* One notch is 120. */
+    distance_ *= std::pow(0.9f, event->angleDelta().y() / 120.0f);
+    distance_ = std::clamp(distance_, radius_ * 0.05f, radius_ * 50.0f);
+    update();
+}
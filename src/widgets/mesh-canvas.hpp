@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_WIDGETS_MESH_CANVAS_HPP_
+#define ACE3X_WIDGETS_MESH_CANVAS_HPP_
+
+#include <QFrame>
+#include <QPoint>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "format-readers/p3d.hpp"
+#include "imaging/rasterizer.hpp"
+
+/* Draws a Geometry with the software rasterizer, one colour per mesh. Drag to
+ * orbit, scroll to zoom. Meshes without indices are drawn as points. */
+class MeshCanvas : public QFrame {
+    Q_OBJECT
+
+public:
+    explicit MeshCanvas(QWidget *parent = nullptr);
+
+    void set_geometry(ace3x::p3d::Geometry geometry);
+    void clear();
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    ace3x::p3d::Geometry geometry_;
+    /* Geometry's indices, made relative to each mesh's first vertex. */
+    std::vector<std::uint32_t> mesh_indices_;
+    std::vector<ace3x::imaging::DrawBatch> batches_;
+    ace3x::imaging::Rasterizer rasterizer_;
+
+    std::array<float, 3> target_ {};
+    float radius_ {1.0f};
+    float distance_ {1.0f};
+    float yaw_ {0.8f};
+    float pitch_ {0.5f};
+    QPoint last_mouse_;
+};
+
+#endif    // ACE3X_WIDGETS_MESH_CANVAS_HPP_
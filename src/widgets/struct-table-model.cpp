@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "widgets/struct-table-model.hpp"
+
+#include <algorithm>
+
+StructTableModel::StructTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void StructTableModel::insert_column(int position, const QString &header, Display display, ValueFunction value)
+{
+    position = std::clamp(position, 0, static_cast<int>(columns_.size()));
+
+    beginInsertColumns(QModelIndex(), position, position);
+    columns_.insert(columns_.begin() + position, {header, display, std::move(value)});
+    endInsertColumns();
+}
+
+void StructTableModel::clear()
+{
+    reset(0, {});
+}
+
+void StructTableModel::reset(std::uint32_t num_rows, std::vector<Column> columns)
+{
+    beginResetModel();
+    num_rows_ = num_rows;
+    columns_ = std::move(columns);
+    endResetModel();
+}
+
+int StructTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(num_rows_);
+}
+
+int StructTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(columns_.size());
+}
+
+QVariant StructTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::UserRole)) {
+        return QVariant();
+    }
+
+    const auto &column = columns_[index.column()];
+    const auto value = column.value(static_cast<std::uint32_t>(index.row()));
+
+    if (role == Qt::UserRole) {
+        return value;
+    }
+
+    switch (column.display) {
+        case Display::Hex: {
+            return QString("0x%1").arg(value.toULongLong(), 0, 16);
+        }
+        case Display::Float: {
+            return QString::number(value.toDouble(), 'G', 4);
+        }
+        default: {
+            return value.toString();
+        }
+    }
+}
+
+QVariant StructTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section;
+    }
+
+    if (section < 0 || section >= static_cast<int>(columns_.size())) {
+        return QVariant();
+    }
+
+    return columns_[section].header;
+}
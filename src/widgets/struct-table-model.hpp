@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_WIDGETS_STRUCT_TABLE_MODEL_HPP_
+#define ACE3X_WIDGETS_STRUCT_TABLE_MODEL_HPP_
+
+#include <QAbstractTableModel>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "format-readers/table.hpp"
+#include "formats/layout.hpp"
+
+/* A read-only model of a Table<T>, one column per field of Layout<T>.
+ *
+ * Cells are read straight from the mapped file, one field at a time, when the
+ * view asks for them, so a table costs nothing until it is scrolled into view.
+ * Qt::DisplayRole gives the formatted text, Qt::UserRole the raw value for
+ * sorting. */
+class StructTableModel : public QAbstractTableModel {
+public:
+    using Display = ace3x::layout::Display;
+    using ValueFunction = std::function<QVariant(std::uint32_t row)>;
+
+    StructTableModel(QObject *parent = nullptr);
+
+    template <typename T>
+    void set_table(const ace3x::Table<T> &table);
+
+    /* Adds a column that is not a field, such as an offset or a name. */
+    void insert_column(int position, const QString &header, Display display, ValueFunction value);
+
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+private:
+    struct Column {
+        QString header;
+        Display display;
+        ValueFunction value;
+    };
+
+    template <typename E>
+    static QVariant to_variant(E value, Display display);
+
+    void reset(std::uint32_t num_rows, std::vector<Column> columns);
+
+private:
+    std::uint32_t num_rows_ {0};
+    std::vector<Column> columns_;
+};
+
+template <typename T>
+void StructTableModel::set_table(const ace3x::Table<T> &table)
+{
+    std::vector<Column> columns;
+    columns.reserve(ace3x::layout::num_columns<T>());
+
+    ace3x::layout::for_each_field<T>([&](const auto &field) {
+        using Field = std::decay_t<decltype(field)>;
+        using Element = typename Field::Element;
+
+        const auto offset = ace3x::layout::offset_of(field);
+        for (std::size_t i = 0; i < Field::kExtent; i++) {
+            const auto header = Field::kExtent == 1 ? QString(field.name) : QString("%1[%2]").arg(field.name).arg(i);
+            const auto element_offset = offset + i * sizeof(Element);
+            const auto display = field.display;
+
+            columns.push_back({header, display, [table, element_offset, display](std::uint32_t row) {
+                                   Element value;
+                                   std::memcpy(&value, table.at(row) + element_offset, sizeof(value));
+                                   return to_variant(value, display);
+                               }});
+        }
+    });
+
+    reset(table.size(), std::move(columns));
+}
+
+template <typename E>
+QVariant StructTableModel::to_variant(E value, Display display)
+{
+    if constexpr (std::is_floating_point_v<E>) {
+        return static_cast<double>(value);
+    }
+    else {
+        if constexpr (sizeof(E) == sizeof(float)) {
+            if (display == Display::Float) {
+                float f;
+                std::memcpy(&f, &value, sizeof(f));
+                return static_cast<double>(f);
+            }
+        }
+
+        if constexpr (std::is_signed_v<E>) {
+            return static_cast<qlonglong>(value);
+        }
+        else {
+            return static_cast<qulonglong>(value);
+        }
+    }
+}
+
+#endif    // ACE3X_WIDGETS_STRUCT_TABLE_MODEL_HPP_
@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#include "widgets/thumbnail-grid.hpp"
+
+#include <QImage>
+#include <QRunnable>
+
+#include "format-readers/peg.hpp"
+#include "imaging/downscale.hpp"
+#include "vfs/advice.hpp"
+#include "vfs/vfs-entry.hpp"
+
+namespace {
+
+class ThumbnailJob : public QRunnable {
+public:
+    ThumbnailJob(QObject *receiver, std::shared_ptr<std::atomic<quint64>> generation, int row, const VfsEntry *frame)
+        : receiver_(receiver)
+        , generation_(std::move(generation))
+        , job_generation_(generation_->load())
+        , row_(row)
+        , frame_(frame)
+    {
+    }
+
+    void run() override
+    {
+        if (generation_->load() != job_generation_) {
+            return;
+        }
+
+        const auto image = ace3x::peg::get_image(frame_->parent->data, frame_->parent->size, frame_->index);
+        if (image.pixels.empty()) {
+            /* Cached as a null pixmap, so the frame is not tried again. */
+            QMetaObject::invokeMethod(receiver_, "thumbnail_ready", Qt::QueuedConnection, Q_ARG(quint64, job_generation_), Q_ARG(int, row_), Q_ARG(QImage, QImage()));
+            return;
+        }
+
+        const auto scaled = ace3x::imaging::fit(image.pixels.data(), image.width, image.height, ThumbnailModel::kThumbnailSize);
+
+        /* The QImage only wraps `scaled`, so send a deep copy. */
+        const auto thumbnail = QImage(reinterpret_cast<const uchar *>(scaled.pixels.data()), scaled.width, scaled.height, QImage::Format_ARGB32).copy();
+
+        QMetaObject::invokeMethod(receiver_, "thumbnail_ready", Qt::QueuedConnection, Q_ARG(quint64, job_generation_), Q_ARG(int, row_), Q_ARG(QImage, thumbnail));
+    }
+
+private:
+    QObject *receiver_;
+    std::shared_ptr<std::atomic<quint64>> generation_;
+    quint64 job_generation_;
+    int row_;
+    const VfsEntry *frame_;
+};
+
+}    // namespace
+
+ThumbnailModel::ThumbnailModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , cache_(64 * 1024)    // KiB
+    , generation_(std::make_shared<std::atomic<quint64>>(0))
+{
+}
+
+ThumbnailModel::~ThumbnailModel()
+{
+    cancel_pending();
+    pool_.waitForDone();
+}
+
+void ThumbnailModel::set_pegs(const std::vector<const VfsEntry *> &pegs)
+{
+    beginResetModel();
+
+    cancel_pending();
+    frames_.clear();
+
+    for (const auto *peg : pegs) {
+        frames_.insert(frames_.end(), peg->entries.begin(), peg->entries.end());
+    }
+
+    endResetModel();
+}
+
+void ThumbnailModel::clear()
+{
+    beginResetModel();
+
+    cancel_pending();
+    frames_.clear();
+
+    endResetModel();
+
+    /* Running jobs still read from the VFS, which may be about to go away. */
+    pool_.waitForDone();
+}
+
+const VfsEntry *ThumbnailModel::frame_at(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(frames_.size())) {
+        return nullptr;
+    }
+
+    return frames_[row];
+}
+
+int ThumbnailModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return static_cast<int>(frames_.size());
+}
+
+QVariant ThumbnailModel::data(const QModelIndex &index, int role) const
+{
+    const auto *frame = frame_at(index.row());
+
+    if (!index.isValid() || !frame) {
+        return QVariant();
+    }
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return QString::fromStdString(frame->name);
+        case Qt::ToolTipRole:
+            return QString::fromStdString(frame->relative_path);
+        case Qt::DecorationRole: {
+            if (const auto *pixmap = cache_.object(index.row())) {
+                return *pixmap;
+            }
+            request(index.row());
+            break;
+        }
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+void ThumbnailModel::request(int row) const
+{
+    if (pending_.contains(row)) {
+        return;
+    }
+
+    pending_.insert(row);
+
+    /* Let the disk catch up while earlier jobs decode. */
+    prefetch_range(frames_[row]->data, frames_[row]->size);
+
+    auto *self = const_cast<ThumbnailModel *>(this);
+    self->pool_.start(new ThumbnailJob(self, generation_, row, frames_[row]), next_priority_++);
+}
+
+void ThumbnailModel::thumbnail_ready(quint64 generation, int row, const QImage &image)
+{
+    if (generation != generation_->load()) {
+        return;
+    }
+
+    pending_.remove(row);
+
+    const int cost = image.width() * image.height() * 4 / 1024 + 1;
+    cache_.insert(row, new QPixmap(QPixmap::fromImage(image)), cost);
+
+    const auto changed = index(row);
+    emit dataChanged(changed, changed, {Qt::DecorationRole});
+}
+
+void ThumbnailModel::cancel_pending()
+{
+    generation_->fetch_add(1);
+    pool_.clear();
+    pending_.clear();
+    cache_.clear();
+    next_priority_ = 0;
+}
+
+ThumbnailGrid::ThumbnailGrid(QWidget *parent)
+    : QListView(parent)
+    , model_(new ThumbnailModel(this))
+{
+    setModel(model_);
+
+    const auto size = ThumbnailModel::kThumbnailSize;
+
+    setViewMode(QListView::IconMode);
+    setResizeMode(QListView::Adjust);
+    setMovement(QListView::Static);
+    setUniformItemSizes(true);
+    setIconSize(QSize(size, size));
+    setGridSize(QSize(size + 24, size + 32));
+    setTextElideMode(Qt::ElideMiddle);
+    setLayoutMode(QListView::Batched);
+    setBatchSize(256);
+
+    connect(this, &QListView::activated, this, [this](const QModelIndex &index) {
+        if (const auto *frame = model_->frame_at(index.row())) {
+            emit frame_activated(frame);
+        }
+    });
+}
+
+void ThumbnailGrid::set_pegs(const std::vector<const VfsEntry *> &pegs)
+{
+    model_->set_pegs(pegs);
+    scrollToTop();
+}
+
+void ThumbnailGrid::clear()
+{
+    model_->clear();
+}
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#ifndef ACE3X_WIDGETS_THUMBNAIL_GRID_HPP_
+#define ACE3X_WIDGETS_THUMBNAIL_GRID_HPP_
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QListView>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+struct VfsEntry;
+
+/* One cell per PEG frame. Thumbnails are decoded on a worker pool the first
+ * time the view asks for a cell's decoration, i.e. only for visible cells,
+ * and kept in a size-bounded cache. */
+class ThumbnailModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    static constexpr int kThumbnailSize {96};
+
+    explicit ThumbnailModel(QObject *parent = nullptr);
+    ~ThumbnailModel();
+
+    /* Frames of every PEG in `pegs`, in order. */
+    void set_pegs(const std::vector<const VfsEntry *> &pegs);
+    void clear();
+    const VfsEntry *frame_at(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+private slots:
+    void thumbnail_ready(quint64 generation, int row, const QImage &image);
+
+private:
+    void request(int row) const;
+    void cancel_pending();
+
+private:
+    std::vector<const VfsEntry *> frames_;
+    mutable QCache<int, QPixmap> cache_;
+    mutable QSet<int> pending_;
+    /* Newer requests get higher priority so the cells scrolled to last are
+     * decoded first. */
+    mutable int next_priority_ {0};
+    /* Bumped on every reset so jobs queued for old contents are dropped. */
+    std::shared_ptr<std::atomic<quint64>> generation_;
+    QThreadPool pool_;
+};
+
+class ThumbnailGrid : public QListView {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailGrid(QWidget *parent = nullptr);
+
+    void set_pegs(const std::vector<const VfsEntry *> &pegs);
+    void clear();
+
+signals:
+    void frame_activated(const VfsEntry *frame);
+
+private:
+    ThumbnailModel *model_;
+};
+
+#endif    // ACE3X_WIDGETS_THUMBNAIL_GRID_HPP_
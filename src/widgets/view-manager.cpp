@@ -1,7 +1,13 @@
 #include "widgets/view-manager.hpp"
 
+#include <spdlog/spdlog.h>
+
 #include <QStackedWidget>
 #include <QVBoxLayout>
+#include <cassert>
+#include <chrono>
+
+#include "startup-trace.hpp"
 
 #include "vfs/vfs-entry.hpp"
 #include "widgets/format-viewers/empty-viewer.hpp"
@@ -15,35 +21,66 @@ ViewManager::ViewManager(QWidget* parent)
     auto* layout = new QVBoxLayout(this);
     layout->addWidget(stack_);
     stack_->addWidget(empty_viewer_);
+    slot_of_format_.fill(kNoSlot);
 }
 
-void ViewManager::add_viewer(const std::string& ext, Viewer* viewer)
+void ViewManager::add_viewer(std::initializer_list<ace3x::FormatId> formats, ViewerFactory factory)
 {
-    assert(!viewers_.count(ext));
-    viewers_[ext] = viewer;
-    if (stack_->indexOf(viewer) == -1) {
-        connect(viewer, &Viewer::referenced_file, this, [this](const std::string& filename) {
-            emit referenced_file(filename);
-        });
-        stack_->addWidget(viewer);
+    for (const auto format : formats) {
+        auto &slot = slot_of_format_[static_cast<std::size_t>(format)];
+        assert(slot == kNoSlot);
+        slot = slots_.size();
     }
+    slots_.push_back({std::move(factory), nullptr});
 }
 
-bool ViewManager::has_viewer(const std::string& ext) const
+bool ViewManager::has_viewer(ace3x::FormatId format) const
 {
-    return viewers_.count(ext);
+    return slot_of_format_[static_cast<std::size_t>(format)] != kNoSlot;
+}
+
+Viewer* ViewManager::viewer_for(ace3x::FormatId format)
+{
+    auto& slot = slots_[slot_of_format_[static_cast<std::size_t>(format)]];
+
+    if (!slot.viewer) {
+        const auto start = std::chrono::steady_clock::now();
+
+        slot.viewer = slot.factory();
+        connect(slot.viewer, &Viewer::referenced_file, this, [this](const std::string& filename) {
+            emit referenced_file(filename);
+        });
+        stack_->addWidget(slot.viewer);
+
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ace3x::startup::enabled()) {
+            spdlog::info("View manager: Created {} in {:.1f} ms", slot.viewer->metaObject()->className(), ms);
+        }
+        else {
+            spdlog::debug("View manager: Created {} in {:.1f} ms", slot.viewer->metaObject()->className(), ms);
+        }
+    }
+
+    return slot.viewer;
 }
 
 void ViewManager::clear()
 {
+    for (auto& slot : slots_) {
+        if (slot.viewer) {
+            slot.viewer->clear();
+        }
+    }
     stack_->setCurrentWidget(empty_viewer_);
     setTitle("No viewer");
 }
 
 void ViewManager::activate_viewer(VfsEntry* entry)
 {
-    assert(viewers_.count(entry->extension));
-    viewers_[entry->extension]->activate(entry);
-    stack_->setCurrentWidget(viewers_[entry->extension]);
+    const auto format = entry_format(entry);
+    assert(has_viewer(format));
+    auto* viewer = viewer_for(format);
+    viewer->activate(entry);
+    stack_->setCurrentWidget(viewer);
     setTitle(QString::fromStdString(entry->extension));
 }
@@ -4,7 +4,12 @@
 #define ACE3X_WIDGETS_VIEW_MANAGER_HPP_
 
 #include <QGroupBox>
-#include <unordered_map>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "format-readers/format-id.hpp"
 
 class EmptyViewer;
 struct VfsEntry;
@@ -17,8 +22,12 @@ class ViewManager : public QGroupBox {
 public:
     ViewManager(QWidget *parent = nullptr);
 
-    void add_viewer(const std::string &ext, Viewer *viewer);
-    bool has_viewer(const std::string &ext) const;
+    using ViewerFactory = std::function<Viewer *()>;
+
+    /* Registers one viewer for formats. It is only constructed, and its UI
+     * set up, when a file of one of them is first viewed. */
+    void add_viewer(std::initializer_list<ace3x::FormatId> formats, ViewerFactory factory);
+    bool has_viewer(ace3x::FormatId format) const;
     void clear();
 
 public slots:
@@ -27,10 +36,21 @@ public slots:
 signals:
     void referenced_file(const std::string &filename);
 
+private:
+    struct Slot {
+        ViewerFactory factory;
+        Viewer *viewer {nullptr};
+    };
+
+    Viewer *viewer_for(ace3x::FormatId format);
+
 private:
     QStackedWidget *stack_;
     Viewer *empty_viewer_;
-    std::unordered_map<std::string, Viewer *> viewers_;
+    std::vector<Slot> slots_;
+    /* Indexed by FormatId, an index into slots_ or kNoSlot. */
+    static constexpr std::size_t kNoSlot {~std::size_t {0}};
+    std::array<std::size_t, ace3x::kFormatCount> slot_of_format_;
 };
 
 #endif    // ACE3X_WIDGETS_VIEW_MANAGER_HPP_
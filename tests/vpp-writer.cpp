@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPLv3-or-later */
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "format-readers/vpp.hpp"
+#include "format-writers/vpp.hpp"
+
+namespace {
+
+using Contents = std::map<std::string, std::vector<unsigned char>>;
+
+std::vector<unsigned char> bytes(std::size_t size, unsigned char seed)
+{
+    std::vector<unsigned char> data(size);
+    for (std::size_t i = 0; i < size; i++) {
+        data[i] = static_cast<unsigned char>(seed + i * 7);
+    }
+    return data;
+}
+
+std::string temporary_path(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void write_archive(const std::string& path, const Contents& contents, const ace3x::vpp::WriteOptions& options = {})
+{
+    std::vector<ace3x::vpp::WriterEntry> entries;
+    for (const auto& [filename, data] : contents) {
+        entries.push_back({filename, data.data(), data.size()});
+    }
+    ace3x::vpp::write(path, entries, options);
+}
+
+std::uint64_t patch_archive(const std::string& path, const Contents& changes)
+{
+    std::vector<ace3x::vpp::WriterEntry> entries;
+    for (const auto& [filename, data] : changes) {
+        entries.push_back({filename, data.data(), data.size()});
+    }
+    return ace3x::vpp::patch(path, entries);
+}
+
+Contents read_archive(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    auto info = ace3x::vpp::read_info(data.data(), path);
+    REQUIRE(info.header.vppSize == data.size());
+
+    /* Like the VFS, read a compressed archive as its header followed by the
+     * inflated data. zlib's own inflate also checks the Adler-32. */
+    std::vector<unsigned char> inflated;
+    if (info.compressed) {
+        const auto* stream = data.data() + info.data_offset;
+        REQUIRE(info.data_offset + info.header.compressedDataSize <= data.size());
+
+        std::vector<unsigned char> checked(info.header.uncompressedDataSize);
+        uLongf checked_size = checked.size();
+        REQUIRE(uncompress(checked.data(), &checked_size, stream, info.header.compressedDataSize) == Z_OK);
+        REQUIRE(checked_size == info.header.uncompressedDataSize);
+
+        inflated.assign(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(info.data_offset));
+        const auto decompressed = ace3x::vpp::decompress(stream, info.header.compressedDataSize, info.header.uncompressedDataSize);
+        inflated.insert(inflated.end(), decompressed.begin(), decompressed.end());
+        REQUIRE(decompressed == checked);
+    }
+
+    const auto& archive = info.compressed ? inflated : data;
+    info.data = archive.data();
+
+    Contents contents;
+    for (const auto& entry : ace3x::vpp::read_entries(info, archive.size())) {
+        const auto begin = archive.begin() + static_cast<std::ptrdiff_t>(entry.offset);
+        contents[entry.filename].assign(begin, begin + static_cast<std::ptrdiff_t>(entry.size));
+    }
+    return contents;
+}
+
+}    // namespace
+
+TEST_CASE("Patching keeps the other entries intact")
+{
+    const auto path = temporary_path("ace3x-vpp-writer-test.vpp");
+
+    Contents contents {
+        {"first.peg", bytes(3000, 1)},
+        {"second.tbl", bytes(100, 2)},
+        {"third.p3d", bytes(5000, 3)},
+    };
+    write_archive(path, contents);
+    REQUIRE(read_archive(path) == contents);
+
+    SUBCASE("Same slot")
+    {
+        const Contents changes {{"SECOND.tbl", bytes(200, 4)}};
+        const auto written = patch_archive(path, changes);
+        contents["second.tbl"] = changes.at("SECOND.tbl");
+
+        CHECK(read_archive(path) == contents);
+        CHECK(written < std::filesystem::file_size(path));
+    }
+
+    SUBCASE("Grow")
+    {
+        const Contents changes {{"first.peg", bytes(9000, 5)}};
+        patch_archive(path, changes);
+        contents["first.peg"] = changes.at("first.peg");
+
+        CHECK(read_archive(path) == contents);
+    }
+
+    SUBCASE("Shrink")
+    {
+        const Contents changes {{"third.p3d", bytes(10, 6)}, {"first.peg", bytes(1, 7)}};
+        patch_archive(path, changes);
+        contents["third.p3d"] = changes.at("third.p3d");
+        contents["first.peg"] = changes.at("first.peg");
+
+        CHECK(read_archive(path) == contents);
+    }
+
+    SUBCASE("Append")
+    {
+        const Contents changes {{"fourth.txt", bytes(4097, 8)}};
+        patch_archive(path, changes);
+        contents["fourth.txt"] = changes.at("fourth.txt");
+
+        CHECK(read_archive(path) == contents);
+    }
+
+    CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Compressed archives read back")
+{
+    const auto path = temporary_path("ace3x-vpp-writer-compressed-test.vpp");
+
+    Contents contents {
+        {"empty.tbl", {}},
+        {"first.peg", bytes(2500, 1)},
+        {"second.tbl", bytes(1, 2)},
+        {"third.p3d", bytes(70001, 3)},
+    };
+
+    /* Blocks that end mid-entry, and entries longer than the 32 KiB window
+     * each block is primed with. */
+    ace3x::vpp::WriteOptions options;
+    options.compress = true;
+    options.block_size = 1000;
+    options.thread_count = 4;
+    write_archive(path, contents, options);
+
+    /* Empty entries are written, but the reader skips them. */
+    contents.erase("empty.tbl");
+    CHECK(read_archive(path) == contents);
+
+    CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+}